@@ -14,14 +14,47 @@ BBC_AUDIOTOOLBOX_START
 class AudioObject
 {
 public:
-  AudioObject() {}
-  virtual ~AudioObject() {}
+  /*--------------------------------------------------------------------------------*/
+  /** Integer handle uniquely representing an object ID (see AudioObjectRegistry)
+   *
+   * @note 0 is never a valid handle
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef uint_t HANDLE;
+
+  AudioObject() : handle(0) {}
+  virtual ~AudioObject() {Unregister();}
   
   /*--------------------------------------------------------------------------------*/
   /** Comparison operator
+   *
+   * @note if both objects have been registered, the handles are compared instead of the IDs
    */
   /*--------------------------------------------------------------------------------*/
-  virtual bool operator == (const AudioObject& obj) const {return (GetID() == obj.GetID());}
+  virtual bool operator == (const AudioObject& obj) const {return (handle && obj.handle) ? (handle == obj.handle) : (GetID() == obj.GetID());}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Register object with AudioObjectRegistry, assigning it a handle
+   *
+   * @return handle for this object's ID
+   *
+   * @note this must be called by derived classes once the ID is valid (it CANNOT be
+   * called from the constructor of this class) and again if the ID changes
+   */
+  /*--------------------------------------------------------------------------------*/
+  HANDLE Register();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove object from AudioObjectRegistry
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Unregister();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Get handle (0 if object has not been registered)
+   */
+  /*--------------------------------------------------------------------------------*/
+  HANDLE GetHandle() const {return handle;}
 
   /*--------------------------------------------------------------------------------*/
   /** Get ID
@@ -79,6 +112,9 @@ public:
 #endif
 
   typedef std::vector<AudioObject *> LIST;
+
+protected:
+  HANDLE handle;
 };
 
 BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,141 @@
+#ifndef __AUDIO_OBJECT_BINARY__
+#define __AUDIO_OBJECT_BINARY__
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <bbcat-base/misc.h>
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Appends little-endian binary data to a byte vector
+ *
+ * Used to generate the binary formats of parameters and timelines, which are independent of
+ * the byte order and structure packing of the machine
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectBinaryWriter
+{
+public:
+  AudioObjectBinaryWriter(std::vector<uint8_t>& _data) : data(_data) {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append value to data
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Write(uint8_t  val) {data.push_back(val);}
+  void Write(uint32_t val) {uint8_t buf[4]; Encode(buf, val, sizeof(buf)); data.insert(data.end(), buf, buf + sizeof(buf));}
+  void Write(uint64_t val) {uint8_t buf[8]; Encode(buf, val, sizeof(buf)); data.insert(data.end(), buf, buf + sizeof(buf));}
+  void Write(float    val) {uint32_t bits; memcpy(&bits, &val, sizeof(bits)); Write(bits);}
+  void Write(double   val) {uint64_t bits; memcpy(&bits, &val, sizeof(bits)); Write(bits);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append string to data as a 32-bit length followed by the characters
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Write(const std::string& val) {Write((uint32_t)val.size()); data.insert(data.end(), val.begin(), val.end());}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write the lowest bytes bytes of val to p in little-endian order
+   */
+  /*--------------------------------------------------------------------------------*/
+  static void Encode(uint8_t *p, uint64_t val, uint_t bytes) {
+    uint_t i;
+    for (i = 0; i < bytes; i++, val >>= 8) p[i] = (uint8_t)val;
+  }
+
+protected:
+  std::vector<uint8_t>& data;
+};
+
+/*--------------------------------------------------------------------------------*/
+/** Reads little-endian binary data from a block of memory with bounds checking
+ *
+ * Any attempt to read beyond the end of the data fails and invalidates the reader so that
+ * a sequence of reads can be checked once at the end using IsValid()
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectBinaryReader
+{
+public:
+  AudioObjectBinaryReader(const uint8_t *_data, uint64_t _size) : data(_data),
+                                                                  size(_size),
+                                                                  pos(0),
+                                                                  valid(true) {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read value from data
+   *
+   * @return true if value was read
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Read(uint8_t& val)  {const uint8_t *p = Take(1); if (p) val = *p; return (p != NULL);}
+  bool Read(uint32_t& val) {const uint8_t *p = Take(4); if (p) val = (uint32_t)Decode(p, 4); return (p != NULL);}
+  bool Read(uint64_t& val) {const uint8_t *p = Take(8); if (p) val = Decode(p, 8); return (p != NULL);}
+  bool Read(float& val)    {uint32_t bits; bool success = Read(bits); if (success) memcpy(&val, &bits, sizeof(val)); return success;}
+  bool Read(double& val)   {uint64_t bits; bool success = Read(bits); if (success) memcpy(&val, &bits, sizeof(val)); return success;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read string written by AudioObjectBinaryWriter
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Read(std::string& val) {
+    const uint8_t *p;
+    uint32_t len;
+    bool success = (Read(len) && ((p = Take(len)) != NULL));
+    if (success) val.assign((const char *)p, len);
+    return success;
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether all reads so far have succeeded
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsValid() const {return valid;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of bytes read so far
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetPosition() const {return pos;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return value of bytes bytes at p in little-endian order
+   */
+  /*--------------------------------------------------------------------------------*/
+  static uint64_t Decode(const uint8_t *p, uint_t bytes) {
+    uint64_t val = 0;
+    uint_t   i;
+    for (i = bytes; i > 0; i--) val = (val << 8) | p[i - 1];
+    return val;
+  }
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Return pointer to the next n bytes and advance past them or NULL if there are not enough bytes left
+   */
+  /*--------------------------------------------------------------------------------*/
+  const uint8_t *Take(uint64_t n) {
+    const uint8_t *p = NULL;
+    if (valid && (n <= (size - pos)))
+    {
+      p    = data + pos;
+      pos += n;
+    }
+    else valid = false;
+    return p;
+  }
+
+protected:
+  const uint8_t *data;
+  uint64_t      size;
+  uint64_t      pos;
+  bool          valid;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
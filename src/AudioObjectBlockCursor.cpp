@@ -0,0 +1,467 @@
+
+#include <algorithm>
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectBlockCursor.h"
+#include "AudioObjectCBOR.h"
+
+BBC_AUDIOTOOLBOX_START
+
+AudioObjectBlockCursor::AudioObjectBlockCursor(uint_t _channel, AudioObject *_object) : AudioObjectCursor(),
+                                                                                         endtime(0),
+                                                                                         seektime(0),
+                                                                                         channel(_channel),
+                                                                                         blockindex(0),
+                                                                                         blocksskipped(0),
+                                                                                         object(_object)
+{
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return index of block that is current at time t (ns) without moving the cursor
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectBlockCursor::FindBlock(uint64_t t) const
+{
+  uint_t lo = 0, hi = (uint_t)blockstarts.size();
+
+  // find first block starting after t
+  while (lo < hi)
+  {
+    uint_t mid = (lo + hi) / 2;
+    if (blockstarts[mid] <= t) lo = mid + 1;
+    else                       hi = mid;
+  }
+
+  // the block before that is the current one (if t is before the first block, use the first block)
+  return lo ? lo - 1 : 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return index of first block starting at or after time t (ns) (the block count if there is none)
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectBlockCursor::FindFirstBlockFrom(uint64_t t) const
+{
+  uint_t n = FindBlock(t), nblocks = GetBlockCount();
+
+  if (n < nblocks)
+  {
+    // FindBlock() returns the last block starting at or before t
+    if (GetBlockStart(n) < t) n++;
+    // step back over any earlier blocks with the same start time
+    else while (n && (GetBlockStart(n - 1) >= t)) n--;
+  }
+
+  return n;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Seek cursor to specified time (ns)
+ *
+ * @return true if the current block changed
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectBlockCursor::Seek(uint64_t t)
+{
+  uint_t n     = GetBlockCount();
+  uint_t index = blockindex;
+
+  seektime = t;
+
+  if (n)
+  {
+    // fast path: still within current block
+    bool within = ((!index || (t >= GetBlockStart(index))) &&
+                   (((index + 1) >= n) || (t < GetBlockStart(index + 1))));
+
+    if (!within)
+    {
+      // fast path: moved into the next block (normal playback)
+      if (((index + 1) < n) && (t >= GetBlockStart(index + 1)) &&
+          (((index + 2) >= n) || (t < GetBlockStart(index + 2)))) index++;
+      // otherwise search
+      else index = FindBlock(t);
+    }
+  }
+  else index = 0;
+
+  blocksskipped = (index > blockindex) ? (index - blockindex - 1) : ((index < blockindex) ? (blockindex - index - 1) : 0);
+
+  bool changed = (index != blockindex);
+  blockindex = index;
+
+  return changed;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return audio object parameters at current time
+ *
+ * @return true if object parameters are valid and returned in currentparameters
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectBlockCursor::GetObjectParameters(AudioObjectParameters& currentparameters) const
+{
+  const AudioObjectParameters *parameters;
+  bool valid = false;
+
+  if ((parameters = GetBlockParameters(blockindex)) != NULL)
+  {
+    currentparameters = *parameters;
+    valid = true;
+  }
+
+  return valid;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append an event for every block starting in the time range [t0, t1) (ns) to list
+ *
+ * @return number of events appended
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectBlockCursor::GetChanges(uint64_t t0, uint64_t t1, CHANGEEVENTS& list) const
+{
+  uint_t i = FindFirstBlockFrom(t0), nblocks = GetBlockCount(), n = 0;
+
+  // the first block is current before its start time so its start is not a change
+  if (!i) i++;
+
+  for (; (i < nblocks) && (GetBlockStart(i) < t1); i++, n++)
+  {
+    CHANGEEVENT event;
+
+    event.t       = GetBlockStart(i);
+    event.channel = channel;
+    event.block   = i;
+    event.cursor  = this;
+
+    list.push_back(event);
+  }
+
+  return n;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return parameters of the block n blocks after the current one without moving the cursor
+ *
+ * @return true if the block exists and its parameters are returned in parameters
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectBlockCursor::Peek(uint_t n, AudioObjectParameters& parameters, uint64_t *t) const
+{
+  const AudioObjectParameters *blockparameters;
+  uint_t index = blockindex + n;
+  bool   valid = false;
+
+  if ((index >= blockindex) && ((blockparameters = GetBlockParameters(index)) != NULL))
+  {
+    parameters = *blockparameters;
+    if (t) *t = GetBlockStart(index);
+    valid = true;
+  }
+
+  return valid;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append the block current at t0 and every block starting in the time range (t0, t1) (ns) to list
+ *
+ * @return number of blocks appended
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectBlockCursor::GetUpcoming(uint64_t t0, uint64_t t1, TIMEDPARAMETERSLIST& list) const
+{
+  uint_t i, first = FindBlock(t0), nblocks = GetBlockCount(), n = 0;
+
+  for (i = first; (i < nblocks) && ((i == first) || (GetBlockStart(i) < t1)); i++)
+  {
+    const AudioObjectParameters *parameters;
+
+    if ((parameters = GetBlockParameters(i)) != NULL)
+    {
+      // construct in place to avoid copying parameters twice
+      list.push_back(TIMEDPARAMETERS());
+      list.back().t          = GetBlockStart(i);
+      list.back().parameters = *parameters;
+      n++;
+    }
+  }
+
+  return n;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Insert block start time into index at position n
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockCursor::InsertBlock(uint_t n, uint64_t t, uint64_t duration)
+{
+  n = std::min(n, (uint_t)blockstarts.size());
+  blockstarts.insert(blockstarts.begin() + n, t);
+  UpdateEndTime(t, duration);
+
+  // the new block may have taken over from the current one
+  blockindex = FindBlock(seektime);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove all blocks from the index
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockCursor::ClearBlocks()
+{
+  blockstarts.clear();
+  endtime       = 0;
+  blockindex    = 0;
+  blocksskipped = 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append CBOR representation of all blocks to data
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockCursor::ToCBOR(std::vector<uint8_t>& data) const
+{
+  AudioObjectCBORWriter writer(data);
+  uint_t i, n = GetBlockCount();
+
+  writer.WriteArray(n);
+  for (i = 0; i < n; i++) BlockToCBOR(i, writer);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write CBOR representation of block n, including its start time
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockCursor::BlockToCBOR(uint_t n, AudioObjectCBORWriter& writer) const
+{
+  const AudioObjectParameters *parameters;
+
+  if ((parameters = GetBlockParameters(n)) != NULL)
+  {
+    parameters->ToCBOR(writer, 1);
+    writer.WriteText(GetBlockStartKey());
+    writer.WriteUnsigned(GetBlockStart(n));
+  }
+  // an empty map keeps the array aligned with the blocks (as BlockToJSON())
+  else writer.WriteMap(0);
+}
+
+#if ENABLE_JSON
+/*--------------------------------------------------------------------------------*/
+/** Convert block n to a JSON object, including its start time
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockCursor::BlockToJSON(uint_t n, json_spirit::mObject& obj) const
+{
+  const AudioObjectParameters *parameters;
+
+  if ((parameters = GetBlockParameters(n)) != NULL)
+  {
+    parameters->ToJSON(obj);
+    obj[GetBlockStartKey()] = bbcat::ToJSON((sint64_t)GetBlockStart(n));
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Convert parameters to a JSON array
+ */
+/*--------------------------------------------------------------------------------*/
+json_spirit::mArray AudioObjectBlockCursor::ToJSONArray() const
+{
+  json_spirit::mArray array;
+  uint_t i, n = GetBlockCount();
+
+  for (i = 0; i < n; i++)
+  {
+    json_spirit::mObject obj;
+    BlockToJSON(i, obj);
+    array.push_back(obj);
+  }
+
+  return array;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Convert parameters to a compact JSON array string, identical to json_spirit::write(ToJSONArray())
+ *
+ * @param pool optional pool of threads to convert blocks on (NULL to convert on the calling thread)
+ * @param chunksize number of blocks converted by each task
+ */
+/*--------------------------------------------------------------------------------*/
+std::string AudioObjectBlockCursor::ToJSONArrayString(TaskPool *pool, uint_t chunksize) const
+{
+  std::vector<const AudioObjectBlockCursor *> cursors(1, this);
+  std::vector<std::string> strings;
+
+  ToJSONArrayStrings(cursors, strings, pool, chunksize);
+
+  return strings[0];
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Convert parameters of a list of cursors to compact JSON array strings, identical to json_spirit::write(ToJSONArray()) of each
+ *
+ * @param cursors list of cursors
+ * @param strings list of strings, resized to the number of cursors and set to the JSON of each
+ * @param pool optional pool of threads to convert blocks on (NULL to convert on the calling thread)
+ * @param chunksize number of blocks converted by each task
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockCursor::ToJSONArrayStrings(const std::vector<const AudioObjectBlockCursor *>& cursors, std::vector<std::string>& strings, TaskPool *pool, uint_t chunksize)
+{
+  typedef struct {
+    uint_t      cursor;
+    uint_t      start;
+    uint_t      end;
+    std::string text;
+  } CHUNK;
+  std::vector<CHUNK> chunks;
+  uint_t i, j;
+
+  if (!chunksize) chunksize = DefaultJSONChunkSize;
+
+  // split each cursor into chunks of blocks (or a single chunk if its blocks cannot be read concurrently)
+  for (i = 0; i < cursors.size(); i++)
+  {
+    uint_t n    = cursors[i]->GetBlockCount();
+    uint_t step = (pool && cursors[i]->IsReadThreadSafe()) ? chunksize : std::max(n, 1U);
+
+    for (j = 0; j < n; j += step)
+    {
+      CHUNK chunk;
+
+      chunk.cursor = i;
+      chunk.start  = j;
+      chunk.end    = std::min(j + step, n);
+      chunks.push_back(chunk);
+    }
+  }
+
+  // a compact array is the compact text of each element separated by commas, so each chunk can be written independently
+  TaskPool::TASK task = [&cursors, &chunks](uint_t n) {
+    CHUNK& chunk = chunks[n];
+    const AudioObjectBlockCursor *cursor = cursors[chunk.cursor];
+    uint_t k;
+
+    for (k = chunk.start; k < chunk.end; k++)
+    {
+      json_spirit::mObject obj;
+
+      cursor->BlockToJSON(k, obj);
+      if (k) chunk.text += ",";
+      chunk.text += json_spirit::write(obj);
+    }
+  };
+
+  if (pool) pool->Run((uint_t)chunks.size(), task);
+  else
+  {
+    for (i = 0; i < chunks.size(); i++) task(i);
+  }
+
+  // concatenate chunks in order
+  std::vector<size_t> lengths(cursors.size(), 2);
+  for (i = 0; i < chunks.size(); i++) lengths[chunks[i].cursor] += chunks[i].text.size();
+
+  strings.resize(cursors.size());
+  for (i = 0; i < cursors.size(); i++)
+  {
+    strings[i].reserve(lengths[i]);
+    strings[i] = "[";
+  }
+  for (i = 0; i < chunks.size(); i++)
+  {
+    strings[chunks[i].cursor] += chunks[i].text;
+    std::string().swap(chunks[i].text);
+  }
+  for (i = 0; i < cursors.size(); i++) strings[i] += "]";
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Convert a page of blocks to a JSON object, allowing a timeline to be sent in pieces
+ *
+ * @param token resume token of the page (returned with the previous page) or empty for the first page
+ * @param limits limits on the size of the page (a page always contains at least one block)
+ * @param obj object to be populated with the page's blocks in a "parameters" array (as ToJSON())
+ * and, if more blocks follow, the resume token of the next page (see GetNextPageKey())
+ * @param next optional pointer to string to receive the resume token of the next page (empty if there are no more blocks)
+ *
+ * @return false if the token is invalid
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectBlockCursor::ToJSONPage(const std::string& token, const PAGELIMITS& limits, json_spirit::mObject& obj, std::string *next) const
+{
+  std::string nexttoken;
+  uint_t n, nblocks = GetBlockCount();
+  bool   success = false;
+
+  if (ParsePageToken(token, n))
+  {
+    json_spirit::mArray array;
+    uint64_t firststart = GetBlockStart(n);
+
+    // always include at least one block so that every page makes progress
+    while ((n < nblocks) &&
+           (array.empty() ||
+            ((!limits.maxblocks   || (array.size() < limits.maxblocks)) &&
+             (!limits.maxduration || ((GetBlockStart(n) - firststart) <= limits.maxduration)))))
+    {
+      json_spirit::mObject blockobj;
+
+      BlockToJSON(n++, blockobj);
+      array.push_back(blockobj);
+    }
+
+    obj["parameters"] = array;
+
+    if (n < nblocks)
+    {
+      nexttoken = StringFrom(n) + ":" + StringFrom(GetBlockStart(n));
+      obj[GetNextPageKey()] = nexttoken;
+    }
+    // obj may hold a previous page, which must not leave its token on the last page
+    else obj.erase(GetNextPageKey());
+
+    success = true;
+  }
+  else BBCERROR("Invalid page token '%s'", token.c_str());
+
+  // set after token has been parsed because next may point to token
+  if (next) *next = nexttoken;
+
+  return success;
+}
+#endif
+
+/*--------------------------------------------------------------------------------*/
+/** Return index of first block of page from resume token
+ *
+ * @return true if token is valid
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectBlockCursor::ParsePageToken(const std::string& token, uint_t& n) const
+{
+  std::string::size_type p;
+  uint64_t start;
+  bool     success = false;
+
+  if (token.empty())
+  {
+    n       = 0;
+    success = true;
+  }
+  else if (((p = token.find(':')) != std::string::npos) &&
+           Evaluate(token.substr(0, p), n) &&
+           Evaluate(token.substr(p + 1), start))
+  {
+    // if the block has moved, find the first block starting at or after the token's start time
+    if ((n >= GetBlockCount()) || (GetBlockStart(n) != start)) n = FindFirstBlockFrom(start);
+    success = true;
+  }
+
+  return success;
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,331 @@
+#ifndef __AUDIO_OBJECT_BLOCK_CURSOR__
+#define __AUDIO_OBJECT_BLOCK_CURSOR__
+
+#include <vector>
+
+#include "AudioObjectCursor.h"
+#include "TaskPool.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Base class for cursors whose parameters are held as a list of blocks, each starting at a given time
+ *
+ * This class maintains a sorted index of block start times and implements Seek() using it:
+ * seeking within the current block or into the next block (i.e. normal playback) takes
+ * constant time, any other seek uses a binary search.
+ *
+ * Block n is current from its start time up to (but not including) the start time of block n + 1.
+ * Before the start of the first block the cursor stays on the first block and after the
+ * start of the last block it stays on the last block.
+ *
+ * Derived classes provide the storage of the block parameters via GetBlockParameters() and
+ * use InsertBlock() etc. to maintain the index.  Derived classes whose index is held elsewhere
+ * (e.g. in a memory-mapped file) can instead override GetBlockCount(), GetBlockStart() and
+ * FindBlock(), leaving the index of this class empty
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectBlockCursor : public AudioObjectCursor
+{
+public:
+  AudioObjectBlockCursor(uint_t _channel = 0, AudioObject *_object = NULL);
+  virtual ~AudioObjectBlockCursor() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return cursor start time in ns
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint64_t GetStartTime() const {return GetBlockCount() ? GetBlockStart(0) : 0;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return cursor end time in ns
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint64_t GetEndTime() const {return endtime;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Seek cursor to specified time (ns)
+   *
+   * @return true if the current block changed
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool Seek(uint64_t t);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return channel for this cursor
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint_t GetChannel() const {return channel;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set/Get current audio object
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void         SetAudioObject(AudioObject *obj) {object = obj;}
+  virtual AudioObject *GetAudioObject() const {return object;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return audio object parameters at current time
+   *
+   * @return true if object parameters are valid and returned in currentparameters
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool GetObjectParameters(AudioObjectParameters& currentparameters) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return pointer to parameters of current block (without copying)
+   *
+   * @return pointer to parameters or NULL if there are no blocks
+   *
+   * @note the returned object is owned by the cursor and is ONLY valid until the cursor is next
+   * seeked or modified
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual const AudioObjectParameters *GetCurrentObjectParameters() const {return GetBlockParameters(blockindex);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append an event for every block starting in the time range [t0, t1) (ns) to list
+   *
+   * @return number of events appended
+   *
+   * @note the first block is current from time 0 so no event is generated for its start
+   * @note the cursor is NOT moved
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint_t GetChanges(uint64_t t0, uint64_t t1, CHANGEEVENTS& list) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return parameters of the block n blocks after the current one without moving the cursor
+   *
+   * @param n number of blocks ahead (0 = current block)
+   * @param parameters object to be updated
+   * @param t optional pointer to variable to receive the start time of the block (ns)
+   *
+   * @return true if the block exists and its parameters are returned in parameters
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool Peek(uint_t n, AudioObjectParameters& parameters, uint64_t *t = NULL) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append the block current at t0 and every block starting in the time range (t0, t1) (ns) to list
+   *
+   * @return number of blocks appended
+   *
+   * @note the cursor is NOT moved and the current block is not used so this may be called
+   * from another thread whilst the cursor is being seeked, as long as no blocks are being added
+   * and GetBlockParameters() of the derived class is thread-safe
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint_t GetUpcoming(uint64_t t0, uint64_t t1, TIMEDPARAMETERSLIST& list) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of blocks
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint_t GetBlockCount() const {return (uint_t)blockstarts.size();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return index of current block
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetBlockIndex() const {return blockindex;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return start time of block n in ns (the end time if n is the block count or beyond)
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint64_t GetBlockStart(uint_t n) const {return (n < blockstarts.size()) ? blockstarts[n] : endtime;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return time of last Seek() in ns
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetSeekTime() const {return seektime;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of blocks passed over (not including the destination block) during the last Seek()
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetBlocksSkipped() const {return blocksskipped;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return index of block that is current at time t (ns) without moving the cursor
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint_t FindBlock(uint64_t t) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return parameters of block n or NULL if n is out of range
+   *
+   * @note the returned object is owned by the cursor and only remains valid until the
+   * cursor is next seeked or modified
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual const AudioObjectParameters *GetBlockParameters(uint_t n) const = 0;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether GetBlockParameters() (and BlockToJSON()) may be called from several threads at once
+   *
+   * @note by default false, derived classes which do not modify anything when returning blocks should return true
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool IsReadThreadSafe() const {return false;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append CBOR representation of all blocks to data
+   *
+   * @note the representation is an array with the same names and structure as ToJSONArray()
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ToCBOR(std::vector<uint8_t>& data) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write CBOR representation of block n, including its start time (as BlockToJSON())
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void BlockToCBOR(uint_t n, AudioObjectCBORWriter& writer) const;
+
+#if ENABLE_JSON
+  /*--------------------------------------------------------------------------------*/
+  /** Convert parameters to a JSON array
+   *
+   * @note each block's start time is included in its object (see GetBlockStartKey())
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual json_spirit::mArray ToJSONArray() const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Convert block n to a JSON object, including its start time
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void BlockToJSON(uint_t n, json_spirit::mObject& obj) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Convert parameters to a compact JSON array string, identical to json_spirit::write(ToJSONArray())
+   *
+   * @param pool optional pool of threads to convert blocks on (NULL to convert on the calling thread)
+   * @param chunksize number of blocks converted by each task
+   *
+   * @note blocks are only converted in parallel if IsReadThreadSafe() returns true
+   */
+  /*--------------------------------------------------------------------------------*/
+  std::string ToJSONArrayString(TaskPool *pool = NULL, uint_t chunksize = DefaultJSONChunkSize) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Convert parameters of a list of cursors to compact JSON array strings, identical to json_spirit::write(ToJSONArray()) of each
+   *
+   * @param cursors list of cursors
+   * @param strings list of strings, resized to the number of cursors and set to the JSON of each
+   * @param pool optional pool of threads to convert blocks on (NULL to convert on the calling thread)
+   * @param chunksize number of blocks converted by each task
+   *
+   * @note cursors whose IsReadThreadSafe() returns false are converted as a single task
+   */
+  /*--------------------------------------------------------------------------------*/
+  static void ToJSONArrayStrings(const std::vector<const AudioObjectBlockCursor *>& cursors, std::vector<std::string>& strings, TaskPool *pool = NULL, uint_t chunksize = DefaultJSONChunkSize);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Limits on the size of a page of blocks (see ToJSONPage())
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef struct {
+    uint_t   maxblocks;       // maximum number of blocks in a page (0 = no limit)
+    uint64_t maxduration;     // maximum time from the start of the first block to the start of the last block of a page (ns, 0 = no limit)
+  } PAGELIMITS;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Convert a page of blocks to a JSON object, allowing a timeline to be sent in pieces
+   *
+   * @param token resume token of the page (returned with the previous page) or empty for the first page
+   * @param limits limits on the size of the page (a page always contains at least one block)
+   * @param obj object to be populated with the page's blocks in a "parameters" array (as ToJSON())
+   * and, if more blocks follow, the resume token of the next page (see GetNextPageKey()), which is
+   * removed otherwise so that obj can be re-used for each page
+   * @param next optional pointer to string to receive the resume token of the next page (empty if there are no more blocks)
+   *
+   * @return false if the token is invalid
+   *
+   * @note the "parameters" arrays of all pages together are identical to ToJSONArray()
+   * @note a token records the index and start time of the next block, if blocks have been added or
+   * removed since the token was generated, the page starts at the first block starting at or after that time
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ToJSONPage(const std::string& token, const PAGELIMITS& limits, json_spirit::mObject& obj, std::string *next = NULL) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return the name used for the resume token of the next page in pages
+   */
+  /*--------------------------------------------------------------------------------*/
+  static const char *GetNextPageKey() {return "next";}
+#endif
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return the name used for a block's start time (ns) in serialised blocks
+   */
+  /*--------------------------------------------------------------------------------*/
+  static const char *GetBlockStartKey() {return "start";}
+
+  enum {
+    DefaultJSONChunkSize = 256,
+  };
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Insert block start time into index at position n
+   *
+   * @param n index of new block (MUST keep the index sorted)
+   * @param t block start time in ns
+   * @param duration block duration in ns (used to update the end time)
+   *
+   * @note the current block is re-evaluated
+   */
+  /*--------------------------------------------------------------------------------*/
+  void InsertBlock(uint_t n, uint64_t t, uint64_t duration);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append block start time to index
+   *
+   * @note t MUST be at or after the start of the last block
+   */
+  /*--------------------------------------------------------------------------------*/
+  void AppendBlock(uint64_t t, uint64_t duration) {InsertBlock(GetBlockCount(), t, duration);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Update end time to include the block at t with the given duration
+   */
+  /*--------------------------------------------------------------------------------*/
+  void UpdateEndTime(uint64_t t, uint64_t duration) {endtime = std::max(endtime, t + duration);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove all blocks from the index
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ClearBlocks();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return index of first block starting at or after time t (ns) (the block count if there is none)
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t FindFirstBlockFrom(uint64_t t) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return index of first block of page from resume token
+   *
+   * @return true if token is valid
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ParsePageToken(const std::string& token, uint_t& n) const;
+
+protected:
+  std::vector<uint64_t> blockstarts;    // unused by derived classes which override GetBlockCount() etc.
+  uint64_t              endtime;
+  uint64_t              seektime;
+  uint_t                channel;
+  uint_t                blockindex;
+  uint_t                blocksskipped;
+  AudioObject           *object;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -0,0 +1,375 @@
+
+#include <algorithm>
+#include <chrono>
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectBlockPipeline.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Time workers wait before retrying when the audio thread has not consumed or returned blocks
+ */
+/*--------------------------------------------------------------------------------*/
+static const std::chrono::milliseconds PollInterval(1);
+
+AudioObjectBlockPipeline::AudioObjectBlockPipeline(AudioObjectBlockCursor *_source, uint_t _queuelength) : source(_source),
+                                                                                                           stopping(false),
+                                                                                                           underruns(0),
+                                                                                                           nblocks(0),
+                                                                                                           queuelength(std::max(_queuelength, 1U)),
+                                                                                                           maxblocks(0),
+                                                                                                           running(false)
+{
+  // blocks in the two queues and the ready ring, one being processed by each stage and one held by the audio thread
+  maxblocks = 3 * queuelength + 4;
+  blocks.reserve(maxblocks);
+}
+
+AudioObjectBlockPipeline::~AudioObjectBlockPipeline()
+{
+  Stop();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Start the worker threads preparing blocks from the one containing time t (ns)
+ *
+ * @note any running pipeline is stopped first
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockPipeline::Start(uint64_t t)
+{
+  uint_t n;
+
+  Stop();
+
+  decoded.Reset(queuelength);
+  transformed.Reset(queuelength);
+  ready.Reset(queuelength);
+  // the finished ring can hold every block so the audio thread never fails to return one
+  finished.Reset(maxblocks);
+
+  nblocks = source->GetBlockCount();
+  stopping.store(false, std::memory_order_release);
+
+  // start from the previous block so that the block containing t is prepared with it
+  if ((n = source->FindBlock(t)) > 0) n--;
+
+  decodethread    = std::thread(&AudioObjectBlockPipeline::DecodeThread, this, n);
+  transformthread = std::thread(&AudioObjectBlockPipeline::TransformThread, this);
+  preparethread   = std::thread(&AudioObjectBlockPipeline::PrepareThread, this);
+  running         = true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Stop the worker threads and discard all prepared blocks
+ *
+ * @note the audio thread MUST NOT call GetBlock() during this call
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockPipeline::Stop()
+{
+  if (running)
+  {
+    uint_t i;
+
+    stopping.store(true, std::memory_order_release);
+    decoded.Shutdown();
+    transformed.Shutdown();
+
+    decodethread.join();
+    transformthread.join();
+    preparethread.join();
+
+    // every block is in the list, wherever it was in the pipeline
+    for (i = 0; i < blocks.size(); i++) delete blocks[i];
+    blocks.clear();
+
+    running = false;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set the list of modifiers applied to each block by the transform stage
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockPipeline::SetModifiers(const AudioObjectParameters::Modifier::LIST& list)
+{
+  std::lock_guard<std::mutex> guard(modifierslock);
+  modifiers = list;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Audio thread: return the prepared block containing time t (ns)
+ *
+ * @return block or NULL if the block is not yet ready (an underrun) or the timeline is empty
+ */
+/*--------------------------------------------------------------------------------*/
+const AudioObjectBlockPipeline::BLOCK *AudioObjectBlockPipeline::GetBlock(uint64_t t)
+{
+  BLOCK *block;
+
+  // return blocks that have finished to the decode stage
+  while (((block = ready.Front()) != NULL) && (block->end <= t))
+  {
+    ready.PopFront();
+    finished.Push(block);
+  }
+
+  // the last block never ends so any missing block is an underrun
+  if (!block && running && nblocks) underruns.fetch_add(1, std::memory_order_relaxed);
+
+  return block;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return value of mul to use with AudioObjectParameters::Interpolate() for block at time t (ns)
+ */
+/*--------------------------------------------------------------------------------*/
+double AudioObjectBlockPipeline::GetInterpolationMul(const BLOCK& block, uint64_t t)
+{
+  double mul = 0.0;
+
+  if      (t <= block.start) mul = 1.0;
+  else if (t < block.interpolationend) mul = 1.0 - (double)(t - block.start) / (double)(block.interpolationend - block.start);
+
+  return mul;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Transform stage: modify block's parameters
+ *
+ * @note by default, applies the pipeline's list of modifiers
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockPipeline::Transform(BLOCK& block)
+{
+  std::lock_guard<std::mutex> guard(modifierslock);
+  if (block.valid && modifiers.size()) block.parameters.Modify(modifiers, source->GetAudioObject());
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Prepare stage: prepare block for interpolation
+ *
+ * @param block block to prepare
+ * @param previous parameters of the last valid block before this one or NULL if there is none
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockPipeline::Prepare(BLOCK& block, const AudioObjectParameters *previous)
+{
+  uint64_t itime;
+
+  block.startparameters = previous ? *previous : block.parameters;
+
+  // Interpolate() converts the start positions into the co-ordinate system of the end positions so do that here instead
+  if (block.startparameters.IsPositionSet() && (block.startparameters.GetPosition().polar != block.parameters.GetPosition().polar))
+  {
+    block.startparameters.SetPosition(block.parameters.GetPosition().polar ? block.startparameters.GetPosition().Polar() : block.startparameters.GetPosition().Cart());
+  }
+  if (block.startparameters.IsMinPositionSet() && (block.startparameters.GetMinPosition().polar != block.parameters.GetMinPosition().polar))
+  {
+    block.startparameters.SetMinPosition(block.parameters.GetMinPosition().polar ? block.startparameters.GetMinPosition().Polar() : block.startparameters.GetMinPosition().Cart());
+  }
+  if (block.startparameters.IsMaxPositionSet() && (block.startparameters.GetMaxPosition().polar != block.parameters.GetMaxPosition().polar))
+  {
+    block.startparameters.SetMaxPosition(block.parameters.GetMaxPosition().polar ? block.startparameters.GetMaxPosition().Polar() : block.startparameters.GetMaxPosition().Cart());
+  }
+
+  // the first block has nothing to interpolate from
+  itime = (previous && block.valid) ? block.parameters.GetActualInterpolationTime() : 0;
+  block.interpolationend = std::min(block.start + itime, block.end);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Decode stage: copy blocks from block n onwards from the source
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockPipeline::DecodeThread(uint_t n)
+{
+  while ((n < nblocks) && !IsStopping())
+  {
+    BLOCK *block;
+
+    // re-use a block finished with by the audio thread or allocate a new one up to the limit
+    if ((block = finished.Front()) != NULL) finished.PopFront();
+    else if (blocks.size() < maxblocks)
+    {
+      block = new BLOCK;
+      blocks.push_back(block);
+    }
+    else
+    {
+      std::this_thread::sleep_for(PollInterval);
+      continue;
+    }
+
+    const AudioObjectParameters *parameters;
+    if ((parameters = source->GetBlockParameters(n)) != NULL)
+    {
+      block->parameters = *parameters;
+      block->valid      = true;
+    }
+    else
+    {
+      BBCERROR("Failed to decode block %u of channel %u", n, source->GetChannel());
+      block->parameters.ResetToDefaults();
+      block->valid = false;
+    }
+    block->start = source->GetBlockStart(n);
+    // the last block holds its parameters indefinitely (it may also have zero duration)
+    block->end   = ((n + 1) < nblocks) ? source->GetBlockStart(n + 1) : ~(uint64_t)0;
+    block->block = n++;
+
+    if (!decoded.Push(block)) break;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Transform stage
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockPipeline::TransformThread()
+{
+  BLOCK *block;
+
+  while ((block = decoded.Pop()) != NULL)
+  {
+    Transform(*block);
+    if (!transformed.Push(block)) break;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Prepare stage: pass prepared blocks to the audio thread
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockPipeline::PrepareThread()
+{
+  AudioObjectParameters previous;
+  BLOCK *block;
+  bool  first = true;
+
+  while ((block = transformed.Pop()) != NULL)
+  {
+    Prepare(*block, first ? NULL : &previous);
+
+    // invalid blocks have default parameters so interpolate from the last valid block instead
+    if (block->valid)
+    {
+      previous = block->parameters;
+      first    = false;
+    }
+
+    // the audio thread cannot signal, so poll for space
+    while (!ready.Push(block))
+    {
+      if (IsStopping()) return;
+      std::this_thread::sleep_for(PollInterval);
+    }
+  }
+}
+
+/*----------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** Add block to queue, waiting for space
+ *
+ * @return false if the queue has been shut down
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectBlockPipeline::Queue::Push(BLOCK *block)
+{
+  std::unique_lock<std::mutex> guard(lock);
+
+  while (!quit && (list.size() >= length)) notfull.wait(guard);
+  if (!quit)
+  {
+    list.push_back(block);
+    notempty.notify_one();
+  }
+
+  return !quit;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove block from queue, waiting for one to be available
+ *
+ * @return block or NULL if the queue has been shut down
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObjectBlockPipeline::BLOCK *AudioObjectBlockPipeline::Queue::Pop()
+{
+  std::unique_lock<std::mutex> guard(lock);
+  BLOCK *block = NULL;
+
+  while (!quit && list.empty()) notempty.wait(guard);
+  if (!quit)
+  {
+    block = list.front();
+    list.pop_front();
+    notfull.notify_one();
+  }
+
+  return block;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Wake up all waiting threads and make them return failure
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockPipeline::Queue::Shutdown()
+{
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    quit = true;
+  }
+  notempty.notify_all();
+  notfull.notify_all();
+}
+
+/*----------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** Producer: add block to ring
+ *
+ * @return false if the ring is full
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectBlockPipeline::Ring::Push(BLOCK *block)
+{
+  uint_t t    = tail.load(std::memory_order_relaxed);
+  uint_t next = (t + 1) % (uint_t)items.size();
+  bool   success = false;
+
+  // acquire ensures the consumer has finished with the slot
+  if (next != head.load(std::memory_order_acquire))
+  {
+    items[t] = block;
+    // release makes the block visible to the consumer
+    tail.store(next, std::memory_order_release);
+    success = true;
+  }
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Consumer: return first block in ring without removing it or NULL if the ring is empty
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObjectBlockPipeline::BLOCK *AudioObjectBlockPipeline::Ring::Front() const
+{
+  uint_t h = head.load(std::memory_order_relaxed);
+  return (h != tail.load(std::memory_order_acquire)) ? items[h] : NULL;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Consumer: remove first block from ring (which MUST exist)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectBlockPipeline::Ring::PopFront()
+{
+  head.store((head.load(std::memory_order_relaxed) + 1) % (uint_t)items.size(), std::memory_order_release);
+}
+
+BBC_AUDIOTOOLBOX_END
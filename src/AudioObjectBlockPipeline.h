@@ -0,0 +1,275 @@
+#ifndef __AUDIO_OBJECT_BLOCK_PIPELINE__
+#define __AUDIO_OBJECT_BLOCK_PIPELINE__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AudioObjectBlockCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** A pipeline of worker threads preparing the blocks of a source cursor ahead of the audio thread
+ *
+ * Each block passes through three stages, each running on its own thread and connected by
+ * bounded queues:
+ * - decode:    the block's parameters are copied from the source cursor (which may decode them on demand)
+ * - transform: the parameters are modified by the pipeline's list of modifiers (see Transform())
+ * - prepare:   the parameters at the start of the block (those of the previous block) are
+ *              converted into the co-ordinate systems of the block and the interpolation
+ *              period is calculated (see Prepare())
+ *
+ * The prepared blocks are passed to the audio thread through a lock-free single-producer/
+ * single-consumer ring and returned, once finished with, through another, so the audio thread
+ * never waits, allocates or frees memory and never decodes or transforms parameters.  The audio
+ * thread uses GetBlock() to find the block for the current time and can interpolate the block's
+ * parameters using AudioObjectParameters::Interpolate() with GetInterpolationMul().
+ *
+ * @note the source cursor is NOT owned and MUST NOT be used by anything else whilst the pipeline is running
+ * @note GetBlock() must only be called from ONE thread (the audio thread) and all other functions
+ * from other threads
+ * @note the number of blocks in the pipeline is bounded so memory use is independent of the timeline length
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectBlockPipeline
+{
+public:
+  /*--------------------------------------------------------------------------------*/
+  /** Constructor
+   *
+   * @param _source source cursor (NOT owned)
+   * @param _queuelength maximum number of blocks waiting between each pair of stages
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObjectBlockPipeline(AudioObjectBlockCursor *_source, uint_t _queuelength = 8);
+  virtual ~AudioObjectBlockPipeline();
+
+  /*--------------------------------------------------------------------------------*/
+  /** A block ready for rendering
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef struct {
+    AudioObjectParameters startparameters;    // parameters at the start of the block (interpolation start values)
+    AudioObjectParameters parameters;         // parameters of the block (interpolation end values)
+    uint64_t              start;              // start time of block (ns)
+    uint64_t              end;                // end time of block (ns, ~0 for the last block)
+    uint64_t              interpolationend;   // time at which the parameters are reached (== start if there is no interpolation)
+    uint_t                block;              // block index in the source cursor
+    bool                  valid;              // false if the source block is invalid
+  } BLOCK;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Start the worker threads preparing blocks from the one containing time t (ns)
+   *
+   * @note any running pipeline is stopped first
+   * @note the block before that is also prepared (and retired by the first GetBlock()) so that
+   * the block containing t interpolates from it exactly as it would during continuous playback
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Start(uint64_t t = 0);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Stop the worker threads and discard all prepared blocks
+   *
+   * @note the audio thread MUST NOT call GetBlock() during this call
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Stop();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether the worker threads are running
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsRunning() const {return running;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set the list of modifiers applied to each block by the transform stage
+   *
+   * @note the new list is applied to blocks transformed after this call, blocks already
+   * in later stages are NOT re-transformed
+   */
+  /*--------------------------------------------------------------------------------*/
+  void SetModifiers(const AudioObjectParameters::Modifier::LIST& list);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Audio thread: return the prepared block containing time t (ns)
+   *
+   * @return block or NULL if the block is not yet ready (an underrun) or the timeline is empty
+   *
+   * @note as with AudioObjectBlockCursor, the first block is returned if t is before it and
+   * the last block is returned for any time after its start
+   * @note blocks ending at or before t are returned to the pipeline so t MUST NOT decrease
+   * (use Start() to seek backwards)
+   * @note the returned block remains valid until the next call with a time beyond its end
+   * @note never waits, allocates or frees memory
+   */
+  /*--------------------------------------------------------------------------------*/
+  const BLOCK *GetBlock(uint64_t t);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return value of mul to use with AudioObjectParameters::Interpolate() for block at time t (ns)
+   *
+   * @note returns 1 at the start of the block (startparameters) falling to 0 at the end of
+   * the interpolation period (parameters)
+   */
+  /*--------------------------------------------------------------------------------*/
+  static double GetInterpolationMul(const BLOCK& block, uint64_t t);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of GetBlock() calls for which the block was not ready
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetUnderrunCount() const {return underruns.load(std::memory_order_relaxed);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return maximum number of blocks allocated by the pipeline
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetMaxBlocks() const {return maxblocks;}
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Transform stage: modify block's parameters
+   *
+   * @note by default, applies the pipeline's list of modifiers
+   * @note called on the transform thread
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void Transform(BLOCK& block);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Prepare stage: prepare block for interpolation
+   *
+   * @param block block to prepare
+   * @param previous parameters of the last valid block before this one or NULL if there is none
+   *
+   * @note called on the prepare thread
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void Prepare(BLOCK& block, const AudioObjectParameters *previous);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Bounded blocking queue of blocks between worker threads
+   */
+  /*--------------------------------------------------------------------------------*/
+  class Queue
+  {
+  public:
+    Queue() : length(0), quit(false) {}
+
+    void Reset(uint_t _length) {list.clear(); length = _length; quit = false;}
+
+    /*--------------------------------------------------------------------------------*/
+    /** Add block to queue, waiting for space
+     *
+     * @return false if the queue has been shut down
+     */
+    /*--------------------------------------------------------------------------------*/
+    bool Push(BLOCK *block);
+
+    /*--------------------------------------------------------------------------------*/
+    /** Remove block from queue, waiting for one to be available
+     *
+     * @return block or NULL if the queue has been shut down
+     */
+    /*--------------------------------------------------------------------------------*/
+    BLOCK *Pop();
+
+    /*--------------------------------------------------------------------------------*/
+    /** Wake up all waiting threads and make them return failure
+     */
+    /*--------------------------------------------------------------------------------*/
+    void Shutdown();
+
+  protected:
+    std::mutex              lock;
+    std::condition_variable notempty;
+    std::condition_variable notfull;
+    std::deque<BLOCK *>     list;
+    uint_t                  length;
+    bool                    quit;
+  };
+
+  /*--------------------------------------------------------------------------------*/
+  /** Lock-free single-producer/single-consumer ring of blocks
+   */
+  /*--------------------------------------------------------------------------------*/
+  class Ring
+  {
+  public:
+    Ring() : head(0), tail(0) {}
+
+    void Reset(uint_t length) {items.resize(length + 1); head = tail = 0;}
+
+    /*--------------------------------------------------------------------------------*/
+    /** Producer: add block to ring
+     *
+     * @return false if the ring is full
+     */
+    /*--------------------------------------------------------------------------------*/
+    bool Push(BLOCK *block);
+
+    /*--------------------------------------------------------------------------------*/
+    /** Consumer: return first block in ring without removing it or NULL if the ring is empty
+     */
+    /*--------------------------------------------------------------------------------*/
+    BLOCK *Front() const;
+
+    /*--------------------------------------------------------------------------------*/
+    /** Consumer: remove first block from ring (which MUST exist)
+     */
+    /*--------------------------------------------------------------------------------*/
+    void PopFront();
+
+  protected:
+    std::vector<BLOCK *> items;
+    std::atomic<uint_t>  head;        // index of first item (written by consumer)
+    std::atomic<uint_t>  tail;        // index after last item (written by producer)
+  };
+
+  /*--------------------------------------------------------------------------------*/
+  /** Worker threads
+   */
+  /*--------------------------------------------------------------------------------*/
+  void DecodeThread(uint_t n);
+  void TransformThread();
+  void PrepareThread();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether the worker threads should stop
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsStopping() const {return stopping.load(std::memory_order_acquire);}
+
+protected:
+  AudioObjectBlockCursor                   *source;
+  std::mutex                               modifierslock;
+  AudioObjectParameters::Modifier::LIST    modifiers;
+  std::vector<BLOCK *>                     blocks;          // all allocated blocks (owned)
+  Queue                                    decoded;         // decode -> transform
+  Queue                                    transformed;     // transform -> prepare
+  Ring                                     ready;           // prepare -> audio thread
+  Ring                                     finished;        // audio thread -> decode
+  std::thread                              decodethread;
+  std::thread                              transformthread;
+  std::thread                              preparethread;
+  std::atomic<bool>                        stopping;
+  std::atomic<uint64_t>                    underruns;
+  uint_t                                   nblocks;
+  uint_t                                   queuelength;
+  uint_t                                   maxblocks;
+  bool                                     running;
+
+private:
+  // prevent copying
+  AudioObjectBlockPipeline(const AudioObjectBlockPipeline& obj);
+  AudioObjectBlockPipeline& operator = (const AudioObjectBlockPipeline& obj);
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
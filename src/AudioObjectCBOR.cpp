@@ -0,0 +1,494 @@
+
+#include <math.h>
+#include <float.h>
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectCBOR.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Count returned by ReadArray() and ReadMap() for indefinite length containers
+ */
+/*--------------------------------------------------------------------------------*/
+static const uint64_t IndefiniteLength = ~(uint64_t)0;
+
+/*--------------------------------------------------------------------------------*/
+/** Additional information values of the initial byte of a data item
+ */
+/*--------------------------------------------------------------------------------*/
+enum {
+  Info_1Byte      = 24,
+  Info_2Bytes     = 25,
+  Info_4Bytes     = 26,
+  Info_8Bytes     = 27,
+  Info_Indefinite = 31,
+};
+
+/*--------------------------------------------------------------------------------*/
+/** Convert single precision value to half precision if it can be represented exactly
+ *
+ * @return true if val can be represented exactly
+ */
+/*--------------------------------------------------------------------------------*/
+static bool SingleToHalf(float val, uint16_t& half)
+{
+  uint32_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+
+  uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+  uint32_t exp  = (bits >> 23) & 0xff;
+  uint32_t mant = bits & 0x7fffff;
+  int      hexp = (int)exp - 127 + 15;
+  bool     exact = false;
+
+  if (exp == 0xff)
+  {
+    // infinity or NaN (whose payload must survive)
+    half  = (uint16_t)(sign | 0x7c00 | (mant >> 13));
+    exact = !(mant & 0x1fff);
+  }
+  else if (!exp && !mant)
+  {
+    // zero
+    half  = sign;
+    exact = true;
+  }
+  else if (exp && (hexp >= 1) && (hexp < 31))
+  {
+    // normal half
+    half  = (uint16_t)(sign | (hexp << 10) | (mant >> 13));
+    exact = !(mant & 0x1fff);
+  }
+  else if (exp && (hexp < 1) && (hexp > -10))
+  {
+    // subnormal half
+    uint32_t full  = mant | 0x800000;
+    uint_t   shift = (uint_t)(14 - hexp);
+
+    half  = (uint16_t)(sign | (full >> shift));
+    exact = !(full & ((1U << shift) - 1));
+  }
+
+  return exact;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Convert half precision value to double (see RFC 8949 Appendix D)
+ */
+/*--------------------------------------------------------------------------------*/
+static double HalfToDouble(uint16_t half)
+{
+  uint_t exp  = (half >> 10) & 0x1f;
+  uint_t mant = half & 0x3ff;
+  double val;
+
+  if      (!exp)       val = ldexp((double)mant, -24);
+  else if (exp != 31)  val = ldexp((double)(mant + 1024), (int)exp - 25);
+  else                 val = mant ? NAN : INFINITY;
+
+  return (half & 0x8000) ? -val : val;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append single precision value, as half precision if that is exact
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectCBORWriter::WriteFloat(float val)
+{
+  uint16_t half;
+
+  if (SingleToHalf(val, half))
+  {
+    data.push_back(Simple_Half);
+    Append(half, sizeof(half));
+  }
+  else
+  {
+    uint32_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+
+    data.push_back(Simple_Single);
+    Append(bits, sizeof(bits));
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append double precision value, as single (or half) precision if that is exact
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectCBORWriter::WriteDouble(double val)
+{
+  // infinities are within range but the conversion of NaNs cannot be checked so they are written as doubles
+  if (((fabs(val) <= FLT_MAX) || (fabs(val) == (double)INFINITY)) && ((double)(float)val == val)) WriteFloat((float)val);
+  else
+  {
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+
+    data.push_back(Simple_Double);
+    Append(bits, sizeof(bits));
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append position as a map of its co-ordinates and whether it is polar
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectCBORWriter::WritePosition(const Position& val)
+{
+  static const char *names[2][3] = {{"x", "y", "z"}, {"az", "el", "d"}};
+  const char * const *elementnames = names[val.polar ? 1 : 0];
+  uint_t i;
+
+  WriteMap(4);
+  WriteText("polar");
+  WriteBool(val.polar);
+  for (i = 0; i < NUMBEROF(val.pos.elements); i++)
+  {
+    WriteText(elementnames[i]);
+    WriteDouble(val.pos.elements[i]);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append rotation as a map of its components
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectCBORWriter::WriteQuaternion(const Quaternion& val)
+{
+  WriteMap(4);
+  WriteText("w");
+  WriteDouble(val.w);
+  WriteText("x");
+  WriteDouble(val.x);
+  WriteText("y");
+  WriteDouble(val.y);
+  WriteText("z");
+  WriteDouble(val.z);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append header of data item using the shortest encoding of val
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectCBORWriter::WriteHead(uint_t major, uint64_t val)
+{
+  uint8_t initial = (uint8_t)(major << 5);
+
+  if (val < Info_1Byte) data.push_back((uint8_t)(initial | val));
+  else if (val <= 0xff)
+  {
+    data.push_back((uint8_t)(initial | Info_1Byte));
+    Append(val, 1);
+  }
+  else if (val <= 0xffff)
+  {
+    data.push_back((uint8_t)(initial | Info_2Bytes));
+    Append(val, 2);
+  }
+  else if (val <= 0xffffffff)
+  {
+    data.push_back((uint8_t)(initial | Info_4Bytes));
+    Append(val, 4);
+  }
+  else
+  {
+    data.push_back((uint8_t)(initial | Info_8Bytes));
+    Append(val, 8);
+  }
+}
+
+/*----------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** Read unsigned integer
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectCBORReader::ReadUnsigned(uint64_t& val)
+{
+  uint64_t v;
+  uint_t   major, info;
+  bool     success = (ReadHead(major, v, info) && ((major == AudioObjectCBORWriter::Major_Unsigned) || Fail()));
+
+  if (success) val = v;
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read signed integer
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectCBORReader::ReadSigned(sint64_t& val)
+{
+  uint64_t v;
+  uint_t   major, info;
+  bool     success = (ReadHead(major, v, info) &&
+                      ((((major == AudioObjectCBORWriter::Major_Unsigned) || (major == AudioObjectCBORWriter::Major_Negative)) &&
+                        (v <= (uint64_t)0x7fffffffffffffffULL)) || Fail()));
+
+  if (success) val = (major == AudioObjectCBORWriter::Major_Negative) ? -1 - (sint64_t)v : (sint64_t)v;
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read number (integer or floating point value of any precision)
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectCBORReader::ReadNumber(double& val)
+{
+  uint64_t v;
+  uint_t   major, info;
+  bool     success = ReadHead(major, v, info);
+
+  if (success)
+  {
+    if      (major == AudioObjectCBORWriter::Major_Unsigned) val = (double)v;
+    else if (major == AudioObjectCBORWriter::Major_Negative) val = -1.0 - (double)v;
+    else if ((major == AudioObjectCBORWriter::Major_Simple) && (info == Info_2Bytes)) val = HalfToDouble((uint16_t)v);
+    else if ((major == AudioObjectCBORWriter::Major_Simple) && (info == Info_4Bytes))
+    {
+      uint32_t bits = (uint32_t)v;
+      float    fval;
+      memcpy(&fval, &bits, sizeof(fval));
+      val = fval;
+    }
+    else if ((major == AudioObjectCBORWriter::Major_Simple) && (info == Info_8Bytes)) memcpy(&val, &v, sizeof(val));
+    else success = Fail();
+  }
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read boolean
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectCBORReader::ReadBool(bool& val)
+{
+  uint64_t v;
+  uint_t   major, info;
+  bool     success = ReadHead(major, v, info);
+
+  if (success)
+  {
+    if ((major == AudioObjectCBORWriter::Major_Simple) && (info < Info_1Byte) && ((v == 20) || (v == 21))) val = (v == 21);
+    else success = Fail();
+  }
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read (definite length) text string
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectCBORReader::ReadText(std::string& val)
+{
+  const uint8_t *p;
+  uint64_t len;
+  uint_t   major, info;
+  bool     success = (ReadHead(major, len, info) &&
+                      (((major == AudioObjectCBORWriter::Major_Text) && (info != Info_Indefinite)) || Fail()) &&
+                      ((p = Take(len)) != NULL));
+
+  if (success) val.assign((const char *)p, (size_t)len);
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read header of an array or map
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectCBORReader::ReadContainer(uint_t type, uint64_t& n)
+{
+  uint64_t v;
+  uint_t   major, info;
+  bool     success = (ReadHead(major, v, info) && ((major == type) || Fail()));
+
+  if (success) n = (info == Info_Indefinite) ? IndefiniteLength : v;
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return whether item i of an array or map of n items follows
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectCBORReader::NextItem(uint64_t n, uint64_t i)
+{
+  bool next = false;
+
+  if (valid)
+  {
+    if (n != IndefiniteLength) next = (i < n);
+    else if (pos < size)
+    {
+      // read the break at the end of the container
+      if (data[pos] == AudioObjectCBORWriter::Simple_Break) pos++;
+      else next = true;
+    }
+    else Fail();
+  }
+
+  return next;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read position written by AudioObjectCBORWriter::WritePosition()
+ *
+ * @note if the polar flag is missing, the position is polar if any polar co-ordinates are present
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectCBORReader::ReadPosition(Position& val)
+{
+  Position    cart, polar;
+  std::string name;
+  uint64_t    i, n;
+  bool        ispolar = false, polarset = false, anypolar = false;
+
+  polar.polar = true;
+
+  if (ReadMap(n))
+  {
+    for (i = 0; NextItem(n, i) && ReadText(name); i++)
+    {
+      if      (name == "polar") polarset = ReadBool(ispolar);
+      else if (name == "x")     ReadNumber(cart.pos.x);
+      else if (name == "y")     ReadNumber(cart.pos.y);
+      else if (name == "z")     ReadNumber(cart.pos.z);
+      else if (name == "az")    anypolar = ReadNumber(polar.pos.az);
+      else if (name == "el")    anypolar = ReadNumber(polar.pos.el);
+      else if (name == "d")     anypolar = ReadNumber(polar.pos.d);
+      else Skip();
+    }
+  }
+
+  if (valid) val = (polarset ? ispolar : anypolar) ? polar : cart;
+
+  return valid;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read rotation written by AudioObjectCBORWriter::WriteQuaternion()
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectCBORReader::ReadQuaternion(Quaternion& val)
+{
+  Quaternion  q;
+  std::string name;
+  uint64_t    i, n;
+
+  if (ReadMap(n))
+  {
+    for (i = 0; NextItem(n, i) && ReadText(name); i++)
+    {
+      if      (name == "w") ReadNumber(q.w);
+      else if (name == "x") ReadNumber(q.x);
+      else if (name == "y") ReadNumber(q.y);
+      else if (name == "z") ReadNumber(q.z);
+      else Skip();
+    }
+  }
+
+  if (valid) val = q;
+
+  return valid;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Skip next data item, which is nested depth containers deep
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectCBORReader::Skip(uint_t depth)
+{
+  uint64_t v, i;
+  uint_t   major, info;
+
+  if (ReadHead(major, v, info))
+  {
+    switch (major)
+    {
+      case AudioObjectCBORWriter::Major_Bytes:
+      case AudioObjectCBORWriter::Major_Text:
+        if (info != Info_Indefinite) Take(v);
+        else Fail();
+        break;
+
+      case AudioObjectCBORWriter::Major_Array:
+      case AudioObjectCBORWriter::Major_Map:
+        if (depth < MaxDepth)
+        {
+          uint64_t n = (info == Info_Indefinite) ? IndefiniteLength : v;
+
+          // each item takes at least one byte so a corrupt count fails quickly
+          for (i = 0; NextItem(n, i); i++)
+          {
+            Skip(depth + 1);
+            // skip value of key/value pair
+            if (major == AudioObjectCBORWriter::Major_Map) Skip(depth + 1);
+          }
+        }
+        else
+        {
+          BBCERROR("CBOR data nested too deeply");
+          Fail();
+        }
+        break;
+
+      case AudioObjectCBORWriter::Major_Simple:
+        // a break outside an indefinite length container is invalid
+        if (info == Info_Indefinite) Fail();
+        break;
+
+      default:
+        // integers: nothing more to skip
+        break;
+    }
+  }
+
+  return valid;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read header of next data item (after any tags)
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectCBORReader::ReadHead(uint_t& major, uint64_t& val, uint_t& info)
+{
+  const uint8_t *p;
+
+  do
+  {
+    if ((p = Take(1)) == NULL) break;
+
+    major = p[0] >> 5;
+    info  = p[0] & 0x1f;
+
+    if (info < Info_1Byte) val = info;
+    else if (info <= Info_8Bytes)
+    {
+      uint_t bytes = 1U << (info - Info_1Byte), i;
+
+      if ((p = Take(bytes)) == NULL) break;
+
+      for (i = 0, val = 0; i < bytes; i++) val = (val << 8) | p[i];
+    }
+    else if (info == Info_Indefinite)
+    {
+      // only valid for strings and containers and for the break
+      if ((major < AudioObjectCBORWriter::Major_Bytes) || (major == AudioObjectCBORWriter::Major_Tag)) Fail();
+      val = 0;
+    }
+    else Fail();
+  }
+  // ignore tags
+  while (valid && (major == AudioObjectCBORWriter::Major_Tag));
+
+  return valid;
+}
+
+BBC_AUDIOTOOLBOX_END
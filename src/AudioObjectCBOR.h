@@ -0,0 +1,254 @@
+#ifndef __AUDIO_OBJECT_CBOR__
+#define __AUDIO_OBJECT_CBOR__
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <bbcat-base/misc.h>
+#include <bbcat-base/3DPosition.h>
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Appends CBOR (RFC 8949) data items to a byte vector
+ *
+ * Used to generate the CBOR formats of parameters, modifiers and timelines, which use the
+ * same names and structure as their JSON formats so that either can be converted to the
+ * other without loss
+ *
+ * Integers and container lengths use the shortest encoding and floating point values use the
+ * shortest of half, single and double precision that represents the value exactly
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectCBORWriter
+{
+public:
+  AudioObjectCBORWriter(std::vector<uint8_t>& _data) : data(_data) {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append value to data
+   */
+  /*--------------------------------------------------------------------------------*/
+  void WriteUnsigned(uint64_t val) {WriteHead(Major_Unsigned, val);}
+  void WriteSigned(sint64_t val)   {if (val < 0) WriteHead(Major_Negative, (uint64_t)(-1 - val)); else WriteHead(Major_Unsigned, (uint64_t)val);}
+  void WriteFloat(float val);
+  void WriteDouble(double val);
+  void WriteBool(bool val)         {data.push_back(val ? Simple_True : Simple_False);}
+  void WriteNull()                 {data.push_back(Simple_Null);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append text string to data
+   */
+  /*--------------------------------------------------------------------------------*/
+  void WriteText(const char *str, size_t len) {WriteHead(Major_Text, len); data.insert(data.end(), (const uint8_t *)str, (const uint8_t *)str + len);}
+  void WriteText(const char *str)             {WriteText(str, strlen(str));}
+  void WriteText(const std::string& str)      {WriteText(str.data(), str.size());}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append header of an array of n items or a map of n key/value pairs to data
+   *
+   * @note the items (or keys and values) MUST be written afterwards
+   */
+  /*--------------------------------------------------------------------------------*/
+  void WriteArray(uint64_t n) {WriteHead(Major_Array, n);}
+  void WriteMap(uint64_t n)   {WriteHead(Major_Map, n);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append position as a map of its co-ordinates and whether it is polar
+   */
+  /*--------------------------------------------------------------------------------*/
+  void WritePosition(const Position& val);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append rotation as a map of its components
+   */
+  /*--------------------------------------------------------------------------------*/
+  void WriteQuaternion(const Quaternion& val);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append header of data item using the shortest encoding of val
+   */
+  /*--------------------------------------------------------------------------------*/
+  void WriteHead(uint_t major, uint64_t val);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Major types and simple values used
+   */
+  /*--------------------------------------------------------------------------------*/
+  enum {
+    Major_Unsigned = 0,
+    Major_Negative,
+    Major_Bytes,
+    Major_Text,
+    Major_Array,
+    Major_Map,
+    Major_Tag,
+    Major_Simple,
+
+    Simple_False   = 0xf4,
+    Simple_True    = 0xf5,
+    Simple_Null    = 0xf6,
+    Simple_Half    = 0xf9,
+    Simple_Single  = 0xfa,
+    Simple_Double  = 0xfb,
+    Simple_Break   = 0xff,
+  };
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Append the lowest bytes bytes of val to data in big-endian order
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Append(uint64_t val, uint_t bytes) {
+    uint_t i;
+    for (i = bytes; i > 0; i--) data.push_back((uint8_t)(val >> (8 * (i - 1))));
+  }
+
+protected:
+  std::vector<uint8_t>& data;
+};
+
+/*--------------------------------------------------------------------------------*/
+/** Reads CBOR (RFC 8949) data items from a block of memory with bounds checking
+ *
+ * Any attempt to read beyond the end of the data or to read an item of the wrong type fails
+ * and invalidates the reader so that a sequence of reads can be checked once at the end using
+ * IsValid()
+ *
+ * Integers and floating point values of any precision are accepted for numbers, tags are
+ * ignored and arrays and maps may be of indefinite length (see NextItem()) but byte and text
+ * strings must be of definite length
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectCBORReader
+{
+public:
+  AudioObjectCBORReader(const uint8_t *_data, uint64_t _size) : data(_data),
+                                                                size(_size),
+                                                                pos(0),
+                                                                valid(true) {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read value from data
+   *
+   * @return true if value was read
+   *
+   * @note ReadNumber() accepts integers as well as floating point values
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadUnsigned(uint64_t& val);
+  bool ReadSigned(sint64_t& val);
+  bool ReadNumber(double& val);
+  bool ReadNumber(float& val) {double dval; bool success = ReadNumber(dval); if (success) val = (float)dval; return success;}
+  bool ReadBool(bool& val);
+  bool ReadText(std::string& val);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read header of an array or map
+   *
+   * @param n variable to receive the number of items (or key/value pairs), which should be passed to NextItem()
+   *
+   * @return true if header was read
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadArray(uint64_t& n) {return ReadContainer(AudioObjectCBORWriter::Major_Array, n);}
+  bool ReadMap(uint64_t& n)   {return ReadContainer(AudioObjectCBORWriter::Major_Map, n);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether item i of an array or map of n items (as returned by ReadArray() or ReadMap()) follows
+   *
+   * @note for indefinite length containers, the terminating break is read when there are no more items
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool NextItem(uint64_t n, uint64_t i);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read position written by AudioObjectCBORWriter::WritePosition()
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadPosition(Position& val);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read rotation written by AudioObjectCBORWriter::WriteQuaternion()
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadQuaternion(Quaternion& val);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Skip next data item (including all items it contains)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Skip() {return Skip(0);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether all reads so far have succeeded
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsValid() const {return valid;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of bytes read so far
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetPosition() const {return pos;}
+
+  enum {
+    MaxDepth = 32,          // maximum depth of nested containers that can be skipped
+  };
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Read header of next data item (after any tags)
+   *
+   * @param major variable to receive the major type
+   * @param val variable to receive the value, length or count (or bits of a floating point value)
+   * @param info variable to receive the additional information (the low 5 bits of the initial byte)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadHead(uint_t& major, uint64_t& val, uint_t& info);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read header of an array or map
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadContainer(uint_t type, uint64_t& n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Skip next data item, which is nested depth containers deep
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Skip(uint_t depth);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Mark reader as invalid and return false
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Fail() {valid = false; return false;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return pointer to the next n bytes and advance past them or NULL if there are not enough bytes left
+   */
+  /*--------------------------------------------------------------------------------*/
+  const uint8_t *Take(uint64_t n) {
+    const uint8_t *p = NULL;
+    if (valid && (n <= (size - pos)))
+    {
+      p    = data + pos;
+      pos += n;
+    }
+    else valid = false;
+    return p;
+  }
+
+protected:
+  const uint8_t *data;
+  uint64_t      size;
+  uint64_t      pos;
+  bool          valid;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -0,0 +1,123 @@
+
+#include <algorithm>
+#include <limits>
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectChangeScheduler.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Add cursor to scheduler
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectChangeScheduler::Add(AudioObjectBlockCursor *cursor)
+{
+  cursors.push_back(cursor);
+  cursor->Seek(currenttime);
+  Schedule((uint_t)(cursors.size() - 1));
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove all cursors
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectChangeScheduler::Clear()
+{
+  cursors.clear();
+  queue.clear();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Queue next block boundary of cursor n (if it has one)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectChangeScheduler::Schedule(uint_t n)
+{
+  const AudioObjectBlockCursor *cursor = cursors[n];
+  uint_t next = cursor->GetBlockIndex() + 1;
+
+  if (next < cursor->GetBlockCount())
+  {
+    ENTRY entry;
+
+    entry.t     = cursor->GetBlockStart(next);
+    entry.index = n;
+
+    queue.push_back(entry);
+    std::push_heap(queue.begin(), queue.end(), &CompareEntries);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Seek all cursors to time t (ns) and rebuild the queue
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectChangeScheduler::Reset(uint64_t t)
+{
+  uint_t i;
+
+  currenttime = t;
+  queue.clear();
+
+  for (i = 0; i < cursors.size(); i++)
+  {
+    cursors[i]->Seek(t);
+    Schedule(i);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return time of next change of any cursor (ns) or the maximum uint64_t value if there are none
+ */
+/*--------------------------------------------------------------------------------*/
+uint64_t AudioObjectChangeScheduler::GetNextChangeTime() const
+{
+  return queue.size() ? queue.front().t : std::numeric_limits<uint64_t>::max();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Process all changes in the time range [t, t + duration) (ns)
+ *
+ * @return number of events appended
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectChangeScheduler::GetChanges(uint64_t t, uint64_t duration, AudioObjectCursor::CHANGEEVENTS& list)
+{
+  uint64_t end = t + duration;
+  uint_t   n   = 0;
+
+  if (t != currenttime)
+  {
+    BBCDEBUG3(("Scheduler discontinuity (expected %lu, got %lu), resetting", (ulong_t)currenttime, (ulong_t)t));
+    Reset(t);
+  }
+
+  while (queue.size() && (queue.front().t < end))
+  {
+    ENTRY entry = queue.front();
+    AudioObjectBlockCursor *cursor = cursors[entry.index];
+    AudioObjectCursor::CHANGEEVENT event;
+
+    std::pop_heap(queue.begin(), queue.end(), &CompareEntries);
+    queue.pop_back();
+
+    cursor->Seek(entry.t);
+
+    event.t       = entry.t;
+    event.channel = cursor->GetChannel();
+    event.block   = cursor->GetBlockIndex();
+    event.cursor  = cursor;
+    list.push_back(event);
+    n++;
+
+    // queue the following boundary
+    Schedule(entry.index);
+  }
+
+  currenttime = end;
+
+  return n;
+}
+
+BBC_AUDIOTOOLBOX_END
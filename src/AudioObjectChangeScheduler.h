@@ -0,0 +1,115 @@
+#ifndef __AUDIO_OBJECT_CHANGE_SCHEDULER__
+#define __AUDIO_OBJECT_CHANGE_SCHEDULER__
+
+#include <vector>
+
+#include "AudioObjectBlockCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Scheduler of parameter changes across a set of block cursors
+ *
+ * A priority queue holds the time of each cursor's next block boundary (the start of the
+ * block following its current one).  For each audio block, only the cursors whose next
+ * boundary falls within the block are seeked, everything else is untouched.  Cursors with
+ * no following block are not in the queue at all.
+ *
+ * Cursors are NOT owned by the scheduler
+ *
+ * @note GetChanges() is expected to be called for contiguous time ranges; if it is not,
+ * the scheduler is Reset() to the new time
+ * @note if blocks are added to cursors after they have been added to the scheduler, Reset() must be called
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectChangeScheduler
+{
+public:
+  AudioObjectChangeScheduler() : currenttime(0) {}
+  ~AudioObjectChangeScheduler() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add cursor to scheduler
+   *
+   * @note the cursor is seeked to the current time of the scheduler
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Add(AudioObjectBlockCursor *cursor);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove all cursors
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Clear();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of cursors
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetCount() const {return (uint_t)cursors.size();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of cursors that have a change scheduled
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetScheduledCount() const {return (uint_t)queue.size();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Seek all cursors to time t (ns) and rebuild the queue
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Reset(uint64_t t);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return current time of scheduler (ns), the end of the last range passed to GetChanges()
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetCurrentTime() const {return currenttime;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return time of next change of any cursor (ns) or the maximum uint64_t value if there are none
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetNextChangeTime() const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Process all changes in the time range [t, t + duration) (ns)
+   *
+   * @param t start of audio block (ns)
+   * @param duration length of audio block (ns)
+   * @param list list to which change events are appended, in time order
+   *
+   * @return number of events appended
+   *
+   * @note each changing cursor is seeked to its change time, cursors that do not change are not touched
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetChanges(uint64_t t, uint64_t duration, AudioObjectCursor::CHANGEEVENTS& list);
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Queue next block boundary of cursor n (if it has one)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Schedule(uint_t n);
+
+  typedef struct {
+    uint64_t t;         // time of next boundary (ns)
+    uint_t   index;     // index of cursor
+  } ENTRY;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Heap comparison function, earliest entry (and lowest cursor index for simultaneous entries) at the top
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool CompareEntries(const ENTRY& entry1, const ENTRY& entry2) {return ((entry1.t > entry2.t) || ((entry1.t == entry2.t) && (entry1.index > entry2.index)));}
+
+protected:
+  std::vector<AudioObjectBlockCursor *> cursors;
+  std::vector<ENTRY>                    queue;
+  uint64_t                              currenttime;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
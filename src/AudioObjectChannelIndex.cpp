@@ -0,0 +1,204 @@
+
+#include <limits>
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectChannelIndex.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Return end time of object for the purposes of the index
+ */
+/*--------------------------------------------------------------------------------*/
+uint64_t AudioObjectChannelIndex::GetEndTime(const AudioObject *obj)
+{
+  uint64_t start = obj->GetStartTime(), end = obj->GetEndTime();
+  // objects with no duration last forever
+  return (end > start) ? end : std::numeric_limits<uint64_t>::max();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Update maximum end times after entry n has been added or removed
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectChannelIndex::UpdateMaxEnd(CHANNEL& channel, uint_t n)
+{
+  const ENTRIES&         entries = channel.entries;
+  std::vector<uint64_t>& maxend  = channel.maxend;
+  uint_t leaves = (uint_t)(maxend.size() / 2);
+  uint_t i;
+
+  if (((n + 1) == entries.size()) && (n < leaves))
+  {
+    // entry appended: only its leaf and the nodes above it change
+    i = leaves + n;
+    maxend[i] = entries[n].end;
+    for (i /= 2; i; i /= 2) maxend[i] = std::max(maxend[2 * i], maxend[2 * i + 1]);
+  }
+  else
+  {
+    // entries have moved (which is already O(n)) or the tree is full: rebuild it
+    // (unused leaves are 0 so they never end after any time)
+    for (leaves = 1; leaves < entries.size(); leaves *= 2) ;
+    maxend.assign(2 * leaves, 0);
+    for (i = 0; i < entries.size(); i++) maxend[leaves + i] = entries[i].end;
+    for (i = leaves - 1; i; i--) maxend[i] = std::max(maxend[2 * i], maxend[2 * i + 1]);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Find the last of the first count entries of channel that ends after t
+ *
+ * @note only one path down the tree is followed beyond the first subtree that lies wholly
+ * within the first count entries and ends after t so this is O(log n)
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectChannelIndex::FindLastEndingAfter(const CHANNEL& channel, uint_t node, uint_t first, uint_t size, uint_t count, uint64_t t, uint_t& index)
+{
+  bool found = false;
+
+  if ((first < count) && (channel.maxend[node] > t))
+  {
+    if (size == 1)
+    {
+      index = first;
+      found = true;
+    }
+    else
+    {
+      // try later entries first
+      size /= 2;
+      found = (FindLastEndingAfter(channel, 2 * node + 1, first + size, size, count, t, index) ||
+               FindLastEndingAfter(channel, 2 * node, first, size, count, t, index));
+    }
+  }
+
+  return found;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add an object to the index
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectChannelIndex::Add(AudioObject *obj)
+{
+  uint_t start = obj->GetStartChannel();
+  uint_t end   = start + obj->GetChannelCount();
+  ENTRY  entry;
+
+  entry.start  = obj->GetStartTime();
+  entry.end    = GetEndTime(obj);
+  entry.object = obj;
+
+  if (end > channels.size()) channels.resize(end);
+
+  uint_t ch;
+  for (ch = start; ch < end; ch++)
+  {
+    ENTRIES& entries = channels[ch].entries;
+    uint_t   pos     = (uint_t)entries.size();
+
+    // objects are normally added in time order so are simply appended
+    if (pos && (entries[pos - 1].start > entry.start))
+    {
+      // otherwise find position after last entry starting at or before this one
+      uint_t lo = 0, hi = pos;
+      while (lo < hi)
+      {
+        uint_t mid = (lo + hi) / 2;
+        if (entries[mid].start <= entry.start) lo = mid + 1;
+        else                                   hi = mid;
+      }
+      pos = lo;
+    }
+
+    entries.insert(entries.begin() + pos, entry);
+    UpdateMaxEnd(channels[ch], pos);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add a list of objects to the index
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectChannelIndex::Add(const AudioObject::LIST& list)
+{
+  uint_t i;
+
+  for (i = 0; i < list.size(); i++) Add(list[i]);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove an object from the index
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectChannelIndex::Remove(const AudioObject *obj)
+{
+  uint_t start = obj->GetStartChannel();
+  uint_t end   = std::min(start + obj->GetChannelCount(), (uint_t)channels.size());
+  uint_t ch;
+
+  for (ch = start; ch < end; ch++)
+  {
+    ENTRIES& entries = channels[ch].entries;
+    uint_t i;
+
+    for (i = 0; i < entries.size(); i++)
+    {
+      if (entries[i].object == obj)
+      {
+        entries.erase(entries.begin() + i);
+        UpdateMaxEnd(channels[ch], i);
+        break;
+      }
+    }
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return object owning channel at time t (ns) or NULL if there is none
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObject *AudioObjectChannelIndex::Find(uint_t channel, uint64_t t) const
+{
+  AudioObject *obj = NULL;
+
+  if (channel < channels.size())
+  {
+    const ENTRIES& entries = channels[channel].entries;
+    uint_t lo = 0, hi = (uint_t)entries.size(), index;
+
+    // find first entry starting after t
+    while (lo < hi)
+    {
+      uint_t mid = (lo + hi) / 2;
+      if (entries[mid].start <= t) lo = mid + 1;
+      else                         hi = mid;
+    }
+
+    // the owner is the last of the entries starting at or before t that ends after t
+    if (FindLastEndingAfter(channels[channel], 1, 0, (uint_t)(channels[channel].maxend.size() / 2), lo, t, index))
+    {
+      obj = entries[index].object;
+    }
+  }
+
+  return obj;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return all objects that use the specified channel at any time
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectChannelIndex::GetObjects(uint_t channel, AudioObject::LIST& list) const
+{
+  if (channel < channels.size())
+  {
+    const ENTRIES& entries = channels[channel].entries;
+    uint_t i;
+
+    for (i = 0; i < entries.size(); i++) list.push_back(entries[i].object);
+  }
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,119 @@
+#ifndef __AUDIO_OBJECT_CHANNEL_INDEX__
+#define __AUDIO_OBJECT_CHANNEL_INDEX__
+
+#include <vector>
+
+#include "AudioObject.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** An index from channel and time to the audio object that owns that channel
+ *
+ * Each audio object covers channels GetStartChannel() to GetStartChannel() + GetChannelCount() - 1
+ * between GetStartTime() (inclusive) and GetEndTime() (exclusive).  For each channel, the
+ * objects are kept sorted by start time along with a tree of the maximum end times of ranges
+ * of them so that the owner of a channel at a given time is found in O(log n), regardless of
+ * gaps or long (or unbounded) objects on the channel.
+ *
+ * @note objects with a zero duration are treated as lasting indefinitely
+ * @note if objects overlap in time on the same channel, the one that started last (or, for
+ * identical start times, was added last) wins
+ * @note objects must not change their channels or times whilst in the index
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectChannelIndex
+{
+public:
+  AudioObjectChannelIndex() {}
+  AudioObjectChannelIndex(const AudioObject::LIST& list) {Add(list);}
+  ~AudioObjectChannelIndex() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add an object to the index
+   *
+   * @note adding objects in start time order is the most efficient
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Add(AudioObject *obj);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add a list of objects to the index
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Add(const AudioObject::LIST& list);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove an object from the index
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Remove(const AudioObject *obj);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Empty the index
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Clear() {channels.clear();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return object owning channel at time t (ns) or NULL if there is none
+   *
+   * @note O(log n) where n is the number of objects on the channel
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObject *Find(uint_t channel, uint64_t t) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return all objects that use the specified channel at any time
+   */
+  /*--------------------------------------------------------------------------------*/
+  void GetObjects(uint_t channel, AudioObject::LIST& list) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of channels covered by the index (one more than the highest channel used)
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetChannelCount() const {return (uint_t)channels.size();}
+
+protected:
+  typedef struct {
+    uint64_t    start;
+    uint64_t    end;
+    AudioObject *object;
+  } ENTRY;
+  typedef std::vector<ENTRY> ENTRIES;
+  typedef struct {
+    ENTRIES               entries;  // sorted by start time
+    std::vector<uint64_t> maxend;   // binary tree of maximum end times: node i has children 2i and 2i + 1, entry n is leaf maxend.size() / 2 + n
+  } CHANNEL;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Update maximum end times after entry n has been added or removed
+   */
+  /*--------------------------------------------------------------------------------*/
+  static void UpdateMaxEnd(CHANNEL& channel, uint_t n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Find the last of the first count entries of channel that ends after t
+   *
+   * @param node node of maxend tree to search, covering entries [first, first + size)
+   * @param index variable to receive index of entry
+   *
+   * @return true if an entry was found
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool FindLastEndingAfter(const CHANNEL& channel, uint_t node, uint_t first, uint_t size, uint_t count, uint64_t t, uint_t& index);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return end time of object for the purposes of the index
+   */
+  /*--------------------------------------------------------------------------------*/
+  static uint64_t GetEndTime(const AudioObject *obj);
+
+protected:
+  std::vector<CHANNEL> channels;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef __AUDIO_OBJECT_CURSOR__
 #define __AUDIO_OBJECT_CURSOR__
 
+#include <vector>
+
 #include "AudioObject.h"
 #include "AudioObjectParameters.h"
 
@@ -19,6 +21,28 @@ public:
   AudioObjectCursor() {}
   virtual ~AudioObjectCursor() {}
 
+  /*--------------------------------------------------------------------------------*/
+  /** A change of parameters at a specific time
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef struct {
+    uint64_t                t;          // time of change (ns)
+    uint_t                  channel;    // channel of cursor
+    uint_t                  block;      // index of block that becomes current at t (cursor specific)
+    const AudioObjectCursor *cursor;    // cursor that changes
+  } CHANGEEVENT;
+  typedef std::vector<CHANGEEVENT> CHANGEEVENTS;
+
+  /*--------------------------------------------------------------------------------*/
+  /** A set of parameters and the time from which they apply
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef struct {
+    uint64_t              t;            // start time of parameters (ns)
+    AudioObjectParameters parameters;
+  } TIMEDPARAMETERS;
+  typedef std::vector<TIMEDPARAMETERS> TIMEDPARAMETERSLIST;
+
   /*--------------------------------------------------------------------------------*/
   /** Return cursor start time in ns
    */
@@ -57,6 +81,92 @@ public:
   /*--------------------------------------------------------------------------------*/
   virtual bool GetObjectParameters(AudioObjectParameters& currentparameters) const = 0;
 
+  /*--------------------------------------------------------------------------------*/
+  /** Return pointer to cursor's own copy of the audio object parameters at current time (without copying)
+   *
+   * @return pointer to parameters or NULL if the cursor cannot provide direct access (or has no parameters)
+   *
+   * @note the returned object is owned by the cursor and is ONLY valid until the cursor is next
+   * seeked or modified
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual const AudioObjectParameters *GetCurrentObjectParameters() const {return NULL;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Copy selected audio object parameters at current time
+   *
+   * @param currentparameters object to be updated
+   * @param mask bitwise-OR of AudioObjectParameters::ParameterMask_xxx values selecting the parameters to copy
+   *
+   * @return true if object parameters are valid and the selected ones copied into currentparameters
+   *
+   * @note parameters not selected by mask are left untouched
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool GetMaskedObjectParameters(AudioObjectParameters& currentparameters, uint_t mask) const {
+    const AudioObjectParameters *parameters;
+    bool valid = false;
+
+    if ((parameters = GetCurrentObjectParameters()) != NULL)
+    {
+      currentparameters.CopyParameters(*parameters, mask);
+      valid = true;
+    }
+    else
+    {
+      // cursor cannot provide direct access so a full copy is unavoidable
+      AudioObjectParameters fullparameters;
+      if ((valid = GetObjectParameters(fullparameters))) currentparameters.CopyParameters(fullparameters, mask);
+    }
+
+    return valid;
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append every parameter change in the time range [t0, t1) (ns) to list, in time order
+   *
+   * @return number of events appended
+   *
+   * @note the cursor is NOT moved
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint_t GetChanges(uint64_t t0, uint64_t t1, CHANGEEVENTS& list) const {
+    UNUSED_PARAMETER(t0);
+    UNUSED_PARAMETER(t1);
+    UNUSED_PARAMETER(list);
+    return 0;
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return parameters n changes ahead of the current ones without moving the cursor
+   *
+   * @param n number of changes ahead (0 = current parameters)
+   * @param parameters object to be updated
+   * @param t optional pointer to variable to receive the start time of the parameters (ns)
+   *
+   * @return true if parameters are valid and returned in parameters
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool Peek(uint_t n, AudioObjectParameters& parameters, uint64_t *t = NULL) const {
+    UNUSED_PARAMETER(t);
+    return (!n && GetObjectParameters(parameters));
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append the parameters current at t0 and every set of parameters starting in the time range (t0, t1) (ns) to list
+   *
+   * @return number of entries appended
+   *
+   * @note the cursor is NOT moved and the result does not depend on the cursor position
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint_t GetUpcoming(uint64_t t0, uint64_t t1, TIMEDPARAMETERSLIST& list) const {
+    UNUSED_PARAMETER(t0);
+    UNUSED_PARAMETER(t1);
+    UNUSED_PARAMETER(list);
+    return 0;
+  }
+
   /*--------------------------------------------------------------------------------*/
   /** Set audio object parameters for current time
    */
@@ -0,0 +1,182 @@
+
+#include <algorithm>
+#include <limits>
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectCursorGroup.h"
+
+BBC_AUDIOTOOLBOX_START
+
+AudioObjectCursorGroup::~AudioObjectCursorGroup()
+{
+  Clear();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add cursor to group
+ *
+ * @return index of cursor within group
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectCursorGroup::Add(AudioObjectCursor *cursor)
+{
+  ENTRY entry;
+
+  entry.cursor      = cursor;
+  entry.blockcursor = dynamic_cast<AudioObjectBlockCursor *>(cursor);
+  // force seek first time
+  entry.blockstart  = 1;
+  entry.blockend    = 0;
+
+  cursors.push_back(entry);
+  changed.resize((cursors.size() + 63) >> 6, 0);
+
+  return (uint_t)(cursors.size() - 1);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Delete all cursors
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectCursorGroup::Clear()
+{
+  uint_t i;
+
+  for (i = 0; i < cursors.size(); i++) delete cursors[i].cursor;
+  cursors.clear();
+  changed.clear();
+  changedcount = 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Force every cursor to be seeked on the next Seek()
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectCursorGroup::Invalidate()
+{
+  uint_t i;
+
+  for (i = 0; i < cursors.size(); i++)
+  {
+    cursors[i].blockstart = 1;
+    cursors[i].blockend   = 0;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Update cached time range of current block for cursor entry n
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectCursorGroup::UpdateRange(uint_t n)
+{
+  ENTRY& entry = cursors[n];
+  const AudioObjectBlockCursor *cursor = entry.blockcursor;
+  uint_t index = cursor->GetBlockIndex();
+
+  // first block extends back to time 0 and last block extends forever
+  entry.blockstart = index ? cursor->GetBlockStart(index) : 0;
+  entry.blockend   = ((index + 1) < cursor->GetBlockCount()) ? cursor->GetBlockStart(index + 1) : std::numeric_limits<uint64_t>::max();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Seek all cursors to time t (ns)
+ *
+ * @return true if any cursor changed
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectCursorGroup::Seek(uint64_t t)
+{
+  uint_t i, n = (uint_t)cursors.size();
+
+  std::fill(changed.begin(), changed.end(), 0);
+  changedcount = 0;
+
+  for (i = 0; i < n; i++)
+  {
+    ENTRY& entry = cursors[i];
+
+    // block cursors only need seeking if t is outside their current block
+    if (!entry.blockcursor || (t < entry.blockstart) || (t >= entry.blockend))
+    {
+      if (entry.cursor->Seek(t))
+      {
+        changed[i >> 6] |= 1ULL << (i & 63);
+        changedcount++;
+      }
+
+      if (entry.blockcursor) UpdateRange(i);
+    }
+  }
+
+  return (changedcount != 0);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Update parameters of cursors that changed during the last Seek()
+ *
+ * @return number of entries updated
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectCursorGroup::GetChangedObjectParameters(std::vector<AudioObjectParameters>& list) const
+{
+  uint_t i, n = 0;
+
+  if (list.size() < cursors.size()) list.resize(cursors.size());
+
+  for (i = 0; i < changed.size(); i++)
+  {
+    uint64_t word = changed[i];
+
+    while (word)
+    {
+      uint_t index = (i << 6) + LowestBit(word);
+
+      if (cursors[index].cursor->GetObjectParameters(list[index])) n++;
+
+      // clear lowest set bit
+      word &= word - 1;
+    }
+  }
+
+  return n;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append every parameter change of every cursor in the time range [t0, t1) (ns) to list
+ *
+ * @return number of events appended
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectCursorGroup::GetChanges(uint64_t t0, uint64_t t1, AudioObjectCursor::CHANGEEVENTS& list) const
+{
+  size_t start = list.size();
+  uint_t i, n = 0;
+
+  for (i = 0; i < cursors.size(); i++) n += cursors[i].cursor->GetChanges(t0, t1, list);
+
+  // each cursor's events are already in time order, stable sort keeps cursor order for simultaneous events
+  std::stable_sort(list.begin() + start, list.end(), &CompareChangeEvents);
+
+  return n;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return index of lowest set bit in non-zero word
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectCursorGroup::LowestBit(uint64_t word)
+{
+#ifdef __GNUC__
+  return (uint_t)__builtin_ctzll(word);
+#else
+  uint_t n = 0;
+  while (!(word & 1))
+  {
+    word >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+BBC_AUDIOTOOLBOX_END
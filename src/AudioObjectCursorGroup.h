@@ -0,0 +1,159 @@
+#ifndef __AUDIO_OBJECT_CURSOR_GROUP__
+#define __AUDIO_OBJECT_CURSOR_GROUP__
+
+#include <vector>
+
+#include "AudioObjectBlockCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** A group of cursors (typically one per track) that are seeked together
+ *
+ * Seek() moves every cursor to a common time and records which cursors changed block in
+ * a bitmap so that only those cursors need to be queried afterwards.
+ *
+ * For cursors derived from AudioObjectBlockCursor, the time range of the current block is
+ * cached by the group so that cursors which stay within their current block are not
+ * seeked at all (saving the virtual call and its checks).  Other cursors are seeked every time.
+ *
+ * @note because cursors staying within their current block are not seeked, cursors that are
+ * used to record parameters (which need to know the time exactly) should be seeked directly
+ * @note if blocks are added to cursors after they have been added to the group, Invalidate()
+ * must be called
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectCursorGroup
+{
+public:
+  AudioObjectCursorGroup() : changedcount(0) {}
+  ~AudioObjectCursorGroup();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add cursor to group
+   *
+   * @return index of cursor within group
+   *
+   * @note the group takes ownership of the cursor and will delete it
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Add(AudioObjectCursor *cursor);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Delete all cursors
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Clear();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of cursors in group
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetCount() const {return (uint_t)cursors.size();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return cursor n
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObjectCursor *GetCursor(uint_t n) const {return (n < cursors.size()) ? cursors[n].cursor : NULL;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Force every cursor to be seeked on the next Seek()
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Invalidate();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Seek all cursors to time t (ns)
+   *
+   * @return true if any cursor changed
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Seek(uint64_t t);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether cursor n changed during the last Seek()
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsChanged(uint_t n) const {return ((n >> 6) < changed.size()) && ((changed[n >> 6] & (1ULL << (n & 63))) != 0);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return bitmap of cursors that changed during the last Seek()
+   *
+   * @note cursor n is represented by bit (n & 63) of word (n >> 6)
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::vector<uint64_t>& GetChanged() const {return changed;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of cursors that changed during the last Seek()
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetChangedCount() const {return changedcount;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return audio object parameters of cursor n at current time
+   *
+   * @return true if object parameters are valid and returned in currentparameters
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool GetObjectParameters(uint_t n, AudioObjectParameters& currentparameters) const {return (n < cursors.size()) && cursors[n].cursor->GetObjectParameters(currentparameters);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Update parameters of cursors that changed during the last Seek()
+   *
+   * @param list list of parameters, one per cursor (will be resized to the number of cursors if necessary)
+   *
+   * @return number of entries updated
+   *
+   * @note entries for cursors that did not change are not touched
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetChangedObjectParameters(std::vector<AudioObjectParameters>& list) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append every parameter change of every cursor in the time range [t0, t1) (ns) to list
+   *
+   * @return number of events appended
+   *
+   * @note events are sorted by time; events at the same time are in cursor order
+   * @note no cursors are moved
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetChanges(uint64_t t0, uint64_t t1, AudioObjectCursor::CHANGEEVENTS& list) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return index of lowest set bit in non-zero word
+   */
+  /*--------------------------------------------------------------------------------*/
+  static uint_t LowestBit(uint64_t word);
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Update cached time range of current block for cursor entry n
+   */
+  /*--------------------------------------------------------------------------------*/
+  void UpdateRange(uint_t n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Comparison function for sorting change events by time
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool CompareChangeEvents(const AudioObjectCursor::CHANGEEVENT& event1, const AudioObjectCursor::CHANGEEVENT& event2) {return (event1.t < event2.t);}
+
+  typedef struct {
+    uint64_t               blockstart;      // cursor need not be seeked whilst blockstart <= t < blockend
+    uint64_t               blockend;
+    AudioObjectCursor      *cursor;
+    AudioObjectBlockCursor *blockcursor;    // same as cursor if it is a block cursor, NULL otherwise
+  } ENTRY;
+
+protected:
+  std::vector<ENTRY>    cursors;
+  std::vector<uint64_t> changed;
+  uint_t                changedcount;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -0,0 +1,63 @@
+
+#include <algorithm>
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectDecodingCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+AudioObjectDecodingCursor::AudioObjectDecodingCursor(uint_t _channel, AudioObject *_object) : AudioObjectBlockCursor(_channel, _object),
+                                                                                               decodecount(0),
+                                                                                               currentslot(0)
+{
+  InvalidateCache();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Invalidate decoded blocks
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectDecodingCursor::InvalidateCache()
+{
+  uint_t i;
+
+  for (i = 0; i < NUMBEROF(cache); i++) cache[i].block = ~0U;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return parameters of block n or NULL if n is out of range or the block cannot be decoded
+ */
+/*--------------------------------------------------------------------------------*/
+const AudioObjectParameters *AudioObjectDecodingCursor::GetBlockParameters(uint_t n) const
+{
+  const AudioObjectParameters *parameters = NULL;
+
+  if (n < GetBlockCount())
+  {
+    uint_t otherslot = 1 - currentslot;
+    uint_t i;
+
+    if (n == blockindex)
+    {
+      // the other slot may hold the current block (e.g. after a Peek() followed by a Seek()),
+      // in which case it becomes the current slot since the block in the current slot is no
+      // longer current
+      if ((cache[currentslot].block != n) && (cache[otherslot].block == n)) std::swap(currentslot, otherslot);
+      i = currentslot;
+    }
+    // never evict the current block for any other block
+    else i = (cache[currentslot].block == n) ? currentslot : otherslot;
+
+    if (cache[i].block != n)
+    {
+      cache[i].block = DecodeBlock(n, cache[i].parameters) ? n : ~0U;
+      decodecount++;
+    }
+
+    if (cache[i].block == n) parameters = &cache[i].parameters;
+  }
+
+  return parameters;
+}
+
+BBC_AUDIOTOOLBOX_END
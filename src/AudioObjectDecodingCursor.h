@@ -0,0 +1,72 @@
+#ifndef __AUDIO_OBJECT_DECODING_CURSOR__
+#define __AUDIO_OBJECT_DECODING_CURSOR__
+
+#include "AudioObjectBlockCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Base class for block cursors whose blocks are held in an encoded form and decoded on demand
+ *
+ * Derived classes decode blocks in DecodeBlock(), this class keeps decoded blocks in a small
+ * cache of two slots: one reserved for the current block (which is only replaced when the
+ * current block changes) and one for any other block, so that normal playback decodes each
+ * block once
+ *
+ * @note these cursors are NOT thread-safe, even for GetUpcoming(), because of the decode cache
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectDecodingCursor : public AudioObjectBlockCursor
+{
+public:
+  AudioObjectDecodingCursor(uint_t _channel = 0, AudioObject *_object = NULL);
+  virtual ~AudioObjectDecodingCursor() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return parameters of block n or NULL if n is out of range or the block cannot be decoded
+   *
+   * @note the returned object is owned by the cursor; for the current block it remains valid
+   * until the cursor is next seeked or modified (see GetCurrentObjectParameters()), for any
+   * other block only until the parameters of another block have been requested
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual const AudioObjectParameters *GetBlockParameters(uint_t n) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of blocks decoded since the cursor was created
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetDecodeCount() const {return decodecount;}
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Decode block n
+   *
+   * @param n block index (always in range)
+   * @param parameters object to receive parameters (may contain a previously decoded block)
+   *
+   * @return true if block was decoded successfully
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool DecodeBlock(uint_t n, AudioObjectParameters& parameters) const = 0;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Invalidate decoded blocks (e.g. when the encoded blocks change)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void InvalidateCache();
+
+  typedef struct {
+    AudioObjectParameters parameters;
+    uint_t                block;      // index of decoded block or ~0 if none
+  } SLOT;
+
+protected:
+  mutable SLOT     cache[2];
+  mutable uint64_t decodecount;
+  mutable uint_t   currentslot;       // slot reserved for the current block
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
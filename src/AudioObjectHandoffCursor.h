@@ -0,0 +1,84 @@
+#ifndef __AUDIO_OBJECT_HANDOFF_CURSOR__
+#define __AUDIO_OBJECT_HANDOFF_CURSOR__
+
+#include "AudioObjectCursor.h"
+#include "AudioObjectParametersHandoff.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** A cursor (typically one per channel) passing live parameter updates from a control thread to an audio thread without locks
+ *
+ * The control thread calls SetObjectParameters() which never waits for the audio thread.
+ * The audio thread calls Seek() to pick up the latest parameters and then reads them using
+ * GetObjectParameters() or GetCurrentObjectParameters() which never wait for the control thread.
+ *
+ * @note SetObjectParameters() must only be called from ONE thread and all other functions
+ * from ONE (other) thread
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectHandoffCursor : public AudioObjectCursor
+{
+public:
+  AudioObjectHandoffCursor(uint_t _channel = 0, AudioObject *_object = NULL) : AudioObjectCursor(),
+                                                                              channel(_channel),
+                                                                              object(_object) {}
+  virtual ~AudioObjectHandoffCursor() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Pick up latest parameters from control thread
+   *
+   * @return true if parameters have changed
+   *
+   * @note the time is ignored since parameters are live
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool Seek(uint64_t t) {UNUSED_PARAMETER(t); return handoff.Update();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return channel for this cursor
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint_t GetChannel() const {return channel;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set/Get current audio object
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void         SetAudioObject(AudioObject *obj) {object = obj;}
+  virtual AudioObject *GetAudioObject() const {return object;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return audio object parameters picked up by the last Seek()
+   *
+   * @return true if object parameters are valid and returned in currentparameters
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool GetObjectParameters(AudioObjectParameters& currentparameters) const {
+    if (handoff.IsValid()) currentparameters = handoff.GetParameters();
+    return handoff.IsValid();
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return pointer to audio object parameters picked up by the last Seek() (without copying)
+   *
+   * @note the returned object is ONLY valid until the cursor is next seeked
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual const AudioObjectParameters *GetCurrentObjectParameters() const {return handoff.IsValid() ? &handoff.GetParameters() : NULL;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Control thread: pass new parameters to audio thread
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void SetObjectParameters(const AudioObjectParameters& newparameters) {handoff.Write(newparameters);}
+
+protected:
+  AudioObjectParametersHandoff handoff;
+  uint_t                       channel;
+  AudioObject                  *object;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
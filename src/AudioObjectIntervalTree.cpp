@@ -0,0 +1,139 @@
+
+#include <algorithm>
+#include <limits>
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectIntervalTree.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Replace contents of tree with list of objects and build the tree
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectIntervalTree::Set(const AudioObject::LIST& list)
+{
+  uint_t i;
+
+  entries.clear();
+  entries.reserve(list.size());
+  for (i = 0; i < list.size(); i++) Add(list[i]);
+
+  Build();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add an object to the tree
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectIntervalTree::Add(AudioObject *obj)
+{
+  ENTRY entry;
+
+  entry.start  = obj->GetStartTime();
+  entry.end    = obj->GetEndTime();
+  // objects with no duration last forever
+  if (entry.end <= entry.start) entry.end = std::numeric_limits<uint64_t>::max();
+  entry.maxend = entry.end;
+  entry.object = obj;
+
+  entries.push_back(entry);
+  dirty = true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** (Re)build tree if objects have been added since it was last built
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectIntervalTree::Build() const
+{
+  if (dirty)
+  {
+    // stable sort keeps objects with the same start time in the order they were added
+    std::stable_sort(entries.begin(), entries.end(), &Compare);
+    Build(0, (uint_t)entries.size());
+    dirty = false;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Calculate maximum end times for the sub-tree covering entries [lo, hi)
+ *
+ * @return maximum end time of sub-tree
+ */
+/*--------------------------------------------------------------------------------*/
+uint64_t AudioObjectIntervalTree::Build(uint_t lo, uint_t hi) const
+{
+  uint64_t maxend = 0;
+
+  if (lo < hi)
+  {
+    uint_t mid = (lo + hi) / 2;
+    ENTRY& entry = entries[mid];
+
+    entry.maxend = std::max(entry.end, std::max(Build(lo, mid), Build(mid + 1, hi)));
+    maxend = entry.maxend;
+  }
+
+  return maxend;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Search sub-tree covering entries [lo, hi) for objects overlapping [t0, t1)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectIntervalTree::Search(uint_t lo, uint_t hi, uint64_t t0, uint64_t t1, AudioObject::LIST& list) const
+{
+  if (lo < hi)
+  {
+    uint_t mid = (lo + hi) / 2;
+    const ENTRY& entry = entries[mid];
+
+    // if nothing in this sub-tree ends after t0, there's nothing to find
+    if (entry.maxend > t0)
+    {
+      Search(lo, mid, t0, t1, list);
+
+      // everything to the right of an object starting at or after t1 also starts at or after t1
+      if (entry.start < t1)
+      {
+        if (entry.end > t0) list.push_back(entry.object);
+
+        Search(mid + 1, hi, t0, t1, list);
+      }
+    }
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Find objects active at time t (ns)
+ *
+ * @return number of objects appended to list
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectIntervalTree::ActiveAt(uint64_t t, AudioObject::LIST& list) const
+{
+  // an object is active at t if it overlaps [t, t + 1)
+  return (t < std::numeric_limits<uint64_t>::max()) ? Overlapping(t, t + 1, list) : 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Find objects active at any point in the window [t0, t1) (ns)
+ *
+ * @return number of objects appended to list
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectIntervalTree::Overlapping(uint64_t t0, uint64_t t1, AudioObject::LIST& list) const
+{
+  size_t n = list.size();
+
+  if (t1 > t0)
+  {
+    Build();
+    Search(0, (uint_t)entries.size(), t0, t1, list);
+  }
+
+  return (uint_t)(list.size() - n);
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,123 @@
+#ifndef __AUDIO_OBJECT_INTERVAL_TREE__
+#define __AUDIO_OBJECT_INTERVAL_TREE__
+
+#include <vector>
+
+#include "AudioObject.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** An interval tree of audio objects for finding which objects are active at a time or over a window
+ *
+ * Each object is active from GetStartTime() (inclusive) to GetEndTime() (exclusive).  Objects
+ * are held in an array sorted by start time, treated as an implicit balanced tree where each
+ * node records the maximum end time of its sub-tree, so that queries take O(log n + k) where k is
+ * the number of objects found.
+ *
+ * Results are appended to a caller supplied list in start time order.
+ *
+ * @note objects with a zero duration are treated as lasting indefinitely
+ * @note objects added using Add() are not searchable until the tree is rebuilt, which happens
+ * automatically on the next query or explicitly using Build(); queries are only safe to run
+ * concurrently once the tree has been built
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectIntervalTree
+{
+public:
+  AudioObjectIntervalTree() : dirty(false) {}
+  AudioObjectIntervalTree(const AudioObject::LIST& list) : dirty(false) {Set(list);}
+  ~AudioObjectIntervalTree() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Replace contents of tree with list of objects and build the tree
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Set(const AudioObject::LIST& list);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add an object to the tree
+   *
+   * @note the tree will be rebuilt on the next query
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Add(AudioObject *obj);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Empty the tree
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Clear() {entries.clear(); dirty = false;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** (Re)build tree if objects have been added since it was last built
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Build() const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of objects in the tree
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetCount() const {return (uint_t)entries.size();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Find objects active at time t (ns)
+   *
+   * @param t time in ns
+   * @param list list to which active objects are appended
+   *
+   * @return number of objects appended to list
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t ActiveAt(uint64_t t, AudioObject::LIST& list) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Find objects active at any point in the window [t0, t1) (ns)
+   *
+   * @param t0 start of window in ns
+   * @param t1 end of window in ns (exclusive)
+   * @param list list to which overlapping objects are appended
+   *
+   * @return number of objects appended to list
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Overlapping(uint64_t t0, uint64_t t1, AudioObject::LIST& list) const;
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Calculate maximum end times for the sub-tree covering entries [lo, hi)
+   *
+   * @return maximum end time of sub-tree
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t Build(uint_t lo, uint_t hi) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Search sub-tree covering entries [lo, hi) for objects overlapping [t0, t1)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Search(uint_t lo, uint_t hi, uint64_t t0, uint64_t t1, AudioObject::LIST& list) const;
+
+  typedef struct {
+    uint64_t    start;
+    uint64_t    end;
+    uint64_t    maxend;           // maximum end time of the sub-tree rooted at this entry
+    AudioObject *object;
+  } ENTRY;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Order entries by start time
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool Compare(const ENTRY& entry1, const ENTRY& entry2) {return (entry1.start < entry2.start);}
+
+protected:
+  mutable std::vector<ENTRY> entries;
+  mutable bool               dirty;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -0,0 +1,226 @@
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectJSONDeltaEmitter.h"
+
+BBC_AUDIOTOOLBOX_START
+
+#if ENABLE_JSON
+/*--------------------------------------------------------------------------------*/
+/** Create list of JSON names of parameters (see GetNames())
+ */
+/*--------------------------------------------------------------------------------*/
+static std::vector<std::string> CreateNames()
+{
+  std::vector<const PARAMETERDESC *> list;
+  std::vector<std::string> names;
+  uint_t i;
+
+  AudioObjectParameters::GetParameterDescriptions(list);
+  for (i = 0; i < list.size(); i++) names.push_back(list[i]->name);
+  // name used by AudioObjectParameters::ToJSON() and FromJSON() (see ParameterMask_excludedzones)
+  names.push_back("excludedzones");
+
+  return names;
+}
+
+AudioObjectJSONDeltaEmitter::AudioObjectJSONDeltaEmitter(uint64_t _keyframeperiod, double _tolerance) : keyframeperiod(_keyframeperiod),
+                                                                                                        keyframecount(0),
+                                                                                                        deltacount(0),
+                                                                                                        unchangedcount(0),
+                                                                                                        tolerance(_tolerance)
+{
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set number of channels
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectJSONDeltaEmitter::SetChannelCount(uint_t n)
+{
+  CHANNEL channel;
+  channel.keyframetime = 0;
+  channel.keyframe     = true;
+  channels.resize(n, channel);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Generate update for channel
+ *
+ * @param channel channel number
+ * @param t time of parameters (ns)
+ * @param parameters current parameters of channel
+ * @param obj object to be set to the update (only modified if an update is generated)
+ *
+ * @return true if an update was generated, false if nothing has changed
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectJSONDeltaEmitter::Emit(uint_t channel, uint64_t t, const AudioObjectParameters& parameters, json_spirit::mObject& obj)
+{
+  if (channel >= channels.size()) SetChannelCount(channel + 1);
+
+  CHANNEL& chan = channels[channel];
+  json_spirit::mObject params;
+  uint_t differences = 0;
+  bool   keyframe = IsKeyframeDue(chan, t);
+  bool   updated  = true;
+
+  if (keyframe)
+  {
+    parameters.ToJSON(params);
+
+    chan.state        = parameters;
+    chan.keyframetime = t;
+    chan.keyframe     = false;
+    keyframecount++;
+  }
+  else if ((differences = parameters.GetDifferences(chan.state, tolerance)) != 0)
+  {
+    const std::vector<std::string>& names = GetNames();
+    uint_t i;
+
+    // output only the changed parameters
+    changes.ResetToDefaults();
+    changes.CopyParameters(parameters, differences);
+    changes.ToJSON(params);
+
+    // changed parameters missing from the output are no longer set
+    for (i = 0; i < names.size(); i++)
+    {
+      if ((differences & (1U << i)) && (params.find(names[i]) == params.end())) params[names[i]] = json_spirit::mValue();
+    }
+
+    // the state is what has been emitted so changes within the tolerance accumulate
+    chan.state.CopyParameters(parameters, differences);
+    deltacount++;
+  }
+  else
+  {
+    unchangedcount++;
+    updated = false;
+  }
+
+  if (updated)
+  {
+    obj.clear();
+    obj[GetChannelKey()]    = (int)channel;
+    obj[GetTimeKey()]       = (sint64_t)t;
+    if (keyframe) obj[GetKeyframeKey()] = true;
+    obj[GetParametersKey()] = params;
+
+    BBCDEBUG3(("Channel %u %s at %s: %u parameters", channel, keyframe ? "keyframe" : "delta", StringFrom(t).c_str(), (uint_t)params.size()));
+  }
+
+  return updated;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Generate update for channel as a compact JSON string
+ *
+ * @return true if an update was generated, false if nothing has changed (str is unmodified)
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectJSONDeltaEmitter::Emit(uint_t channel, uint64_t t, const AudioObjectParameters& parameters, std::string& str)
+{
+  json_spirit::mObject obj;
+  bool success = Emit(channel, t, parameters, obj);
+
+  if (success) str = json_spirit::write(obj);
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Force the next update of channel to be a keyframe
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectJSONDeltaEmitter::RequestKeyframe(uint_t channel)
+{
+  // new channels start with a keyframe anyway
+  if (channel < channels.size()) channels[channel].keyframe = true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Force the next update of every channel to be a keyframe
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectJSONDeltaEmitter::RequestKeyframes()
+{
+  uint_t i;
+
+  for (i = 0; i < channels.size(); i++) channels[i].keyframe = true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return whether the next update of channel at time t must be a keyframe
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectJSONDeltaEmitter::IsKeyframeDue(const CHANNEL& channel, uint64_t t) const
+{
+  return (channel.keyframe ||
+          (t < channel.keyframetime) ||
+          (keyframeperiod && (t >= (channel.keyframetime + keyframeperiod))));
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Apply update generated by Emit() to parameters
+ *
+ * @param obj update
+ * @param parameters parameters of the update's channel to be updated
+ *
+ * @return false if obj is not a valid update
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectJSONDeltaEmitter::Apply(const json_spirit::mObject& obj, AudioObjectParameters& parameters)
+{
+  json_spirit::mObject::const_iterator it;
+  bool success = false;
+
+  if (((it = obj.find(GetParametersKey())) != obj.end()) && (it->second.type() == json_spirit::obj_type))
+  {
+    const json_spirit::mObject& params = it->second.get_obj();
+    bool keyframe = (((it = obj.find(GetKeyframeKey())) != obj.end()) && (it->second.type() == json_spirit::bool_type) && it->second.get_bool());
+
+    if (keyframe) parameters.FromJSON(params);
+    else
+    {
+      const std::vector<std::string>& names = GetNames();
+      AudioObjectParameters update;
+      json_spirit::mObject  values;
+      uint_t i, mask = 0;
+
+      // FromJSON() cannot be used directly since it would remove unchanged excluded zones,
+      // instead decode the non-null values and copy all parameters present in the update
+      for (it = params.begin(); it != params.end(); ++it)
+      {
+        if (it->second.type() != json_spirit::null_type) values[it->first] = it->second;
+      }
+      update.FromJSON(values);
+
+      for (i = 0; i < names.size(); i++)
+      {
+        if (params.find(names[i]) != params.end()) mask |= 1U << i;
+      }
+
+      parameters.CopyParameters(update, mask);
+    }
+
+    success = true;
+  }
+  else BBCERROR("Invalid JSON update '%s'", json_spirit::write(obj).c_str());
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return JSON names of parameters in Parameter_t order followed by that of the excluded zones
+ */
+/*--------------------------------------------------------------------------------*/
+const std::vector<std::string>& AudioObjectJSONDeltaEmitter::GetNames()
+{
+  // initialised once, on first use
+  static const std::vector<std::string> names = CreateNames();
+  return names;
+}
+#endif
+
+BBC_AUDIOTOOLBOX_END
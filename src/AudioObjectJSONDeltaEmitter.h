@@ -0,0 +1,180 @@
+#ifndef __AUDIO_OBJECT_JSON_DELTA_EMITTER__
+#define __AUDIO_OBJECT_JSON_DELTA_EMITTER__
+
+#include <string>
+#include <vector>
+
+#include "AudioObjectParameters.h"
+
+BBC_AUDIOTOOLBOX_START
+
+#if ENABLE_JSON
+/*--------------------------------------------------------------------------------*/
+/** Generates a stream of JSON updates per channel containing only the parameters that have changed
+ *
+ * Each channel's parameters are compared against the parameters last emitted for that channel
+ * and, if any differ, an update is generated containing the channel, the time and a "parameters"
+ * object containing only the changed parameters, as they would be output by
+ * AudioObjectParameters::ToJSON().  Parameters that are no longer set are output as null.
+ *
+ * Periodically (and for the first update of each channel) a keyframe is generated instead,
+ * containing all parameters, so that a receiver joining the stream late (or losing an update)
+ * can recover the full state.  Keyframes are marked with "keyframe": true.
+ *
+ * Apply() reconstructs the parameters of a channel from its stream of updates.
+ *
+ * @note this class is NOT thread-safe
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectJSONDeltaEmitter
+{
+public:
+  /*--------------------------------------------------------------------------------*/
+  /** Constructor
+   *
+   * @param _keyframeperiod time between keyframes of each channel (ns, 0 = only the first update is a keyframe)
+   * @param _tolerance maximum absolute difference allowed between numeric values before they are considered changed
+   * (in each value's own units, see AudioObjectParameters::Matches())
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObjectJSONDeltaEmitter(uint64_t _keyframeperiod = DefaultKeyframePeriod, double _tolerance = 0.0);
+  virtual ~AudioObjectJSONDeltaEmitter() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set/Get time between keyframes of each channel (ns, 0 = only the first update is a keyframe)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void     SetKeyframePeriod(uint64_t period) {keyframeperiod = period;}
+  uint64_t GetKeyframePeriod() const {return keyframeperiod;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set/Get maximum absolute difference allowed between numeric values before they are considered changed
+   *
+   * @note differences are measured against the values last emitted so small changes accumulate until they are emitted
+   */
+  /*--------------------------------------------------------------------------------*/
+  void   SetTolerance(double _tolerance) {tolerance = _tolerance;}
+  double GetTolerance() const {return tolerance;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set/Get number of channels
+   *
+   * @note channels are added automatically by Emit()
+   */
+  /*--------------------------------------------------------------------------------*/
+  void   SetChannelCount(uint_t n);
+  uint_t GetChannelCount() const {return (uint_t)channels.size();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Generate update for channel
+   *
+   * @param channel channel number
+   * @param t time of parameters (ns)
+   * @param parameters current parameters of channel
+   * @param obj object to be set to the update (only modified if an update is generated)
+   *
+   * @return true if an update was generated, false if nothing has changed
+   *
+   * @note a keyframe is generated for the first update of a channel, once the keyframe period
+   * has elapsed since the last keyframe, if time goes backwards (e.g. after a seek) or if one
+   * has been requested using RequestKeyframe()
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Emit(uint_t channel, uint64_t t, const AudioObjectParameters& parameters, json_spirit::mObject& obj);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Generate update for channel as a compact JSON string
+   *
+   * @return true if an update was generated, false if nothing has changed (str is unmodified)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Emit(uint_t channel, uint64_t t, const AudioObjectParameters& parameters, std::string& str);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Force the next update of channel to be a keyframe
+   */
+  /*--------------------------------------------------------------------------------*/
+  void RequestKeyframe(uint_t channel);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Force the next update of every channel to be a keyframe (e.g. when a receiver connects)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void RequestKeyframes();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return parameters last emitted for channel
+   */
+  /*--------------------------------------------------------------------------------*/
+  const AudioObjectParameters& GetState(uint_t channel) const {return (channel < channels.size()) ? channels[channel].state : emptyparameters;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of keyframes and deltas generated and the number of calls to Emit() which generated nothing
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetKeyframeCount()  const {return keyframecount;}
+  uint64_t GetDeltaCount()     const {return deltacount;}
+  uint64_t GetUnchangedCount() const {return unchangedcount;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Apply update generated by Emit() to parameters
+   *
+   * @param obj update
+   * @param parameters parameters of the update's channel to be updated
+   *
+   * @return false if obj is not a valid update
+   *
+   * @note deltas MUST be applied in order to the result of the previous keyframe
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool Apply(const json_spirit::mObject& obj, AudioObjectParameters& parameters);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return the names used in updates
+   */
+  /*--------------------------------------------------------------------------------*/
+  static const char *GetChannelKey()    {return "channel";}
+  static const char *GetTimeKey()       {return "time";}
+  static const char *GetKeyframeKey()   {return "keyframe";}
+  static const char *GetParametersKey() {return "parameters";}
+
+  enum {
+    DefaultKeyframePeriod = 1000000000,     // 1s
+  };
+
+protected:
+  typedef struct {
+    AudioObjectParameters state;          // parameters last emitted
+    uint64_t              keyframetime;   // time of last keyframe
+    bool                  keyframe;       // true if next update must be a keyframe
+  } CHANNEL;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether the next update of channel at time t must be a keyframe
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsKeyframeDue(const CHANNEL& channel, uint64_t t) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return JSON names of parameters in Parameter_t order followed by that of the excluded zones
+   *
+   * @note name n corresponds to ParameterMask_xxx value (1U << n)
+   */
+  /*--------------------------------------------------------------------------------*/
+  static const std::vector<std::string>& GetNames();
+
+protected:
+  std::vector<CHANNEL>        channels;
+  AudioObjectParameters       changes;            // changed parameters of the current update
+  uint64_t                    keyframeperiod;
+  uint64_t                    keyframecount;
+  uint64_t                    deltacount;
+  uint64_t                    unchangedcount;
+  double                      tolerance;
+  const AudioObjectParameters emptyparameters;
+};
+#endif
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
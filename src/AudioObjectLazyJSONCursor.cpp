@@ -0,0 +1,297 @@
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectLazyJSONCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+#if ENABLE_JSON
+/*--------------------------------------------------------------------------------*/
+/** Remove all blocks
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectLazyJSONCursor::Clear()
+{
+  text.clear();
+  ranges.clear();
+  ClearBlocks();
+  InvalidateCache();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Replace blocks with those in JSON text
+ *
+ * @return true if the text was scanned successfully (on failure, the cursor has no blocks)
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectLazyJSONCursor::SetText(const std::string& _text)
+{
+  const char *begin, *end, *p;
+  uint64_t   maxendtime = 0;
+  uint_t     i, n;
+
+  Clear();
+
+  text  = _text;
+  begin = text.data();
+  end   = begin + text.size();
+
+  if ((p = SkipWhitespace(begin, end)) < end)
+  {
+    // array of blocks
+    if (*p == '[') p = ScanArray(p, end, ranges, maxendtime);
+    // object containing array of blocks
+    else if (*p == '{')
+    {
+      bool found = false;
+
+      p++;
+      while (p && !found && ((p = SkipWhitespace(p, end)) < end) && (*p == '"'))
+      {
+        const char *key = p;
+
+        if ((p = SkipString(p, end)) != NULL)
+        {
+          const char *keyend = p;
+
+          if (((p = SkipWhitespace(p, end)) < end) && (*p == ':') && ((p = SkipWhitespace(p + 1, end)) < end))
+          {
+            if (IsKey(key, keyend, "parameters") && (*p == '['))
+            {
+              p     = ScanArray(p, end, ranges, maxendtime);
+              found = true;
+            }
+            else if (((p = SkipValue(p, end)) != NULL) && ((p = SkipWhitespace(p, end)) < end) && (*p == ',')) p++;
+          }
+          else p = NULL;
+        }
+      }
+
+      if (!found) p = NULL;
+    }
+    else p = NULL;
+  }
+  else p = NULL;
+
+  if (!p)
+  {
+    BBCERROR("Failed to scan JSON timeline");
+    Clear();
+    return false;
+  }
+
+  // blocks are normally in order but FromJSONArray() allows any order, with later blocks replacing earlier ones with the same start
+  std::stable_sort(ranges.begin(), ranges.end(), &CompareRanges);
+  for (i = n = 0; i < ranges.size(); i++)
+  {
+    if (n && (ranges[n - 1].start == ranges[i].start)) ranges[n - 1] = ranges[i];
+    else ranges[n++] = ranges[i];
+  }
+  ranges.resize(n);
+
+  blockstarts.resize(n);
+  for (i = 0; i < n; i++) blockstarts[i] = ranges[i].start;
+  endtime    = maxendtime;
+  blockindex = FindBlock(seektime);
+
+  BBCDEBUG3(("Scanned %u blocks of JSON timeline", n));
+
+  return true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Scan array of blocks starting at p, appending each block's range to list
+ *
+ * @return pointer to character after array or NULL on error
+ */
+/*--------------------------------------------------------------------------------*/
+const char *AudioObjectLazyJSONCursor::ScanArray(const char *p, const char *end, std::vector<RANGE>& list, uint64_t& maxendtime) const
+{
+  uint64_t t = 0;
+
+  // skip '['
+  p++;
+
+  while (((p = SkipWhitespace(p, end)) < end) && (*p != ']'))
+  {
+    if (*p == '{')
+    {
+      const char *block = p;
+      uint64_t   start = 0, duration = 0;
+      bool       hasstart = false;
+
+      // scan top level of block for start time and duration, skipping all other values
+      p++;
+      while (((p = SkipWhitespace(p, end)) < end) && (*p == '"'))
+      {
+        const char *key = p, *keyend, *value;
+
+        if (!(p = SkipString(p, end)) || ((p = SkipWhitespace(keyend = p, end)) >= end) || (*p != ':')) return NULL;
+        if (!(p = SkipValue(value = SkipWhitespace(p + 1, end), end))) return NULL;
+
+        if      (IsKey(key, keyend, GetBlockStartKey())) hasstart = ParseNumber(value, p, start);
+        else if (IsKey(key, keyend, "duration"))         ParseNumber(value, p, duration);
+
+        if (((p = SkipWhitespace(p, end)) < end) && (*p == ',')) p++;
+      }
+
+      if ((p >= end) || (*p != '}')) return NULL;
+      p++;
+
+      RANGE range;
+
+      // blocks without a start time follow on from the previous block
+      if (hasstart) t = start;
+
+      range.start  = t;
+      range.offset = block - text.data();
+      range.length = p - block;
+      list.push_back(range);
+
+      maxendtime = std::max(maxendtime, t + duration);
+      t += duration;
+    }
+    else
+    {
+      BBCERROR("Block %u of timeline is not an object", (uint_t)list.size());
+      if (!(p = SkipValue(p, end))) return NULL;
+    }
+
+    if (((p = SkipWhitespace(p, end)) < end) && (*p == ',')) p++;
+  }
+
+  return (p < end) ? p + 1 : NULL;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Skip whitespace
+ */
+/*--------------------------------------------------------------------------------*/
+const char *AudioObjectLazyJSONCursor::SkipWhitespace(const char *p, const char *end)
+{
+  while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n'))) p++;
+  return p;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Skip quoted string (p must point to the opening quote)
+ */
+/*--------------------------------------------------------------------------------*/
+const char *AudioObjectLazyJSONCursor::SkipString(const char *p, const char *end)
+{
+  for (p++; p < end; p++)
+  {
+    if      (*p == '\\') p++;
+    else if (*p == '"')  return p + 1;
+  }
+
+  return NULL;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Skip any JSON value
+ */
+/*--------------------------------------------------------------------------------*/
+const char *AudioObjectLazyJSONCursor::SkipValue(const char *p, const char *end)
+{
+  if (p >= end) return NULL;
+
+  if (*p == '"') return SkipString(p, end);
+
+  if ((*p == '{') || (*p == '['))
+  {
+    uint_t depth = 0;
+
+    while (p < end)
+    {
+      if (*p == '"')
+      {
+        if (!(p = SkipString(p, end))) return NULL;
+        continue;
+      }
+
+      if      ((*p == '{') || (*p == '[')) depth++;
+      else if (((*p == '}') || (*p == ']')) && !--depth) return p + 1;
+      p++;
+    }
+
+    return NULL;
+  }
+
+  // number or literal
+  const char *start = p;
+  while ((p < end) && *p && !strchr(",}] \t\r\n", *p)) p++;
+
+  return (p > start) ? p : NULL;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Parse number in the range [p, end)
+ *
+ * @return true if the range is a number
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectLazyJSONCursor::ParseNumber(const char *p, const char *end, uint64_t& val)
+{
+  std::string str(p, end - p);
+  const char *s = str.c_str();
+  char       *endp;
+  bool       success = false;
+
+  if (str.find_first_of(".eE") == std::string::npos)
+  {
+    sint64_t ival = strtoll(s, &endp, 10);
+    if ((endp != s) && !*endp)
+    {
+      val     = (uint64_t)ival;
+      success = true;
+    }
+  }
+  else
+  {
+    double dval = strtod(s, &endp);
+    if ((endp != s) && !*endp)
+    {
+      val     = (uint64_t)(sint64_t)dval;
+      success = true;
+    }
+  }
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return whether the quoted string in the range [p, end) is key
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectLazyJSONCursor::IsKey(const char *p, const char *end, const char *key)
+{
+  size_t len = strlen(key);
+  return (((size_t)(end - p) == (len + 2)) && (memcmp(p + 1, key, len) == 0));
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Parse block n
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectLazyJSONCursor::DecodeBlock(uint_t n, AudioObjectParameters& parameters) const
+{
+  json_spirit::mValue value;
+  bool success = false;
+
+  if (json_spirit::read(text.substr(ranges[n].offset, ranges[n].length), value) && (value.type() == json_spirit::obj_type))
+  {
+    parameters.FromJSON(value.get_obj());
+    success = true;
+  }
+  else BBCERROR("Failed to parse block %u of JSON timeline", n);
+
+  return success;
+}
+#endif
+
+BBC_AUDIOTOOLBOX_END
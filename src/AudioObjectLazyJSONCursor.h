@@ -0,0 +1,122 @@
+#ifndef __AUDIO_OBJECT_LAZY_JSON_CURSOR__
+#define __AUDIO_OBJECT_LAZY_JSON_CURSOR__
+
+#include <string>
+#include <vector>
+
+#include "AudioObjectDecodingCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+#if ENABLE_JSON
+/*--------------------------------------------------------------------------------*/
+/** A cursor holding a JSON timeline as text, parsing each block only when it is used
+ *
+ * SetText() performs a fast structural scan of the text to find the byte range and start time
+ * of each block (without parsing any parameters) and keeps the text.  Each block's text is only
+ * parsed and converted using AudioObjectParameters::FromJSON() when the block is used (see
+ * AudioObjectDecodingCursor).
+ *
+ * The text is either a JSON object as generated by AudioObjectCursor::ToJSON() or a JSON array
+ * as generated by AudioObjectBlockCursor::ToJSONArray().  As with AudioObjectTimelineCursor::FromJSONArray(),
+ * blocks without a start time are placed directly after the previous block.
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectLazyJSONCursor : public AudioObjectDecodingCursor
+{
+public:
+  AudioObjectLazyJSONCursor(uint_t _channel = 0, AudioObject *_object = NULL) : AudioObjectDecodingCursor(_channel, _object) {}
+  virtual ~AudioObjectLazyJSONCursor() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Replace blocks with those in JSON text
+   *
+   * @return true if the text was scanned successfully (on failure, the cursor has no blocks)
+   *
+   * @note the JSON of the blocks themselves is NOT validated until they are parsed
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool SetText(const std::string& _text);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove all blocks
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Clear();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return text of block n
+   */
+  /*--------------------------------------------------------------------------------*/
+  std::string GetBlockText(uint_t n) const {return (n < ranges.size()) ? text.substr(ranges[n].offset, ranges[n].length) : "";}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Parse block n into parameters without using (or updating) the cache
+   *
+   * @return true if block was parsed successfully
+   *
+   * @note may be called from several threads at once (as long as the text is not changed)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ParseBlock(uint_t n, AudioObjectParameters& parameters) const {return (n < ranges.size()) && DecodeBlock(n, parameters);}
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Parse block n
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool DecodeBlock(uint_t n, AudioObjectParameters& parameters) const;
+
+  typedef struct {
+    uint64_t               start;       // start time of block (ns)
+    std::string::size_type offset;      // offset of block object in text
+    std::string::size_type length;      // length of block object in text
+  } RANGE;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Scan array of blocks starting at p, appending each block's range to list
+   *
+   * @return pointer to character after array or NULL on error
+   */
+  /*--------------------------------------------------------------------------------*/
+  const char *ScanArray(const char *p, const char *end, std::vector<RANGE>& list, uint64_t& maxendtime) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Scanning helpers
+   *
+   * @return pointer to character after the item or NULL on error
+   */
+  /*--------------------------------------------------------------------------------*/
+  static const char *SkipWhitespace(const char *p, const char *end);
+  static const char *SkipString(const char *p, const char *end);
+  static const char *SkipValue(const char *p, const char *end);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Parse number in the range [p, end)
+   *
+   * @return true if the range is a number
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool ParseNumber(const char *p, const char *end, uint64_t& val);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether the quoted string in the range [p, end) is key
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool IsKey(const char *p, const char *end, const char *key);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Comparison function for sorting ranges by start time
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool CompareRanges(const RANGE& a, const RANGE& b) {return (a.start < b.start);}
+
+protected:
+  std::string        text;
+  std::vector<RANGE> ranges;
+};
+#endif
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -2,8 +2,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <map>
+
 #define BBCDEBUG_LEVEL 1
 #include "AudioObjectParameters.h"
+#include "AudioObjectBinary.h"
+#include "AudioObjectCBOR.h"
+#include "AudioObjectRegistry.h"
 
 BBC_AUDIOTOOLBOX_START
 
@@ -113,6 +119,39 @@ void AudioObjectParameters::InitialiseToDefaults()
   ResetExcludedZones();
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Reset all parameters to their defaults
+ *
+ * @note unlike construction, min and max positions are NOT deleted and remain
+ * allocated (but reset) so that the object can be re-used without heap churn
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectParameters::ResetToDefaults()
+{
+  // reset all values to zero
+  memset(&values, 0, sizeof(values));
+
+  // reset set bitmap
+  setbitmap = 0;
+
+  // explicitly reset those parameters whose reset values are not zero
+  ResetPosition();
+  ResetGain();
+  ResetObjectImportance();
+  ResetChannelImportance();
+  ResetInterpolate();
+
+  // only replace othervalues if there is anything to remove
+  if (!othervalues.IsEmpty()) ResetOtherValues();
+
+  // reset (but keep) min and max position
+  ClearParameter<>(Parameter_minposition, &minposition);
+  ClearParameter<>(Parameter_maxposition, &maxposition);
+
+  // delete entire chain of excluded zones
+  ResetExcludedZones();
+}
+
 /*--------------------------------------------------------------------------------*/
 /** Assignment operator
  */
@@ -127,10 +166,11 @@ AudioObjectParameters& AudioObjectParameters::operator = (const AudioObjectParam
     othervalues    = obj.othervalues;
     setbitmap      = obj.setbitmap;
 
+    // min and max positions are kept allocated (if they already are) to avoid heap churn on re-used objects
     if (obj.IsMinPositionSet()) SetMinPosition(obj.GetMinPosition());
-    else                        ResetMinPosition();
+    else                        ClearParameter<>(Parameter_minposition, &minposition);
     if (obj.IsMaxPositionSet()) SetMaxPosition(obj.GetMaxPosition());
-    else                        ResetMaxPosition();
+    else                        ClearParameter<>(Parameter_maxposition, &maxposition);
 
     // delete entire chain of excluded zones
     ResetExcludedZones();
@@ -352,6 +392,76 @@ bool AudioObjectParameters::operator == (const AudioObjectParameters& obj) const
   return same;
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Return whether selected parameters match those of another object, allowing a tolerance on numeric values
+ *
+ * @param obj object to compare against
+ * @param tolerance maximum absolute difference allowed between numeric values in their own units
+ * (see header)
+ * @param mask bitwise-OR of ParameterMask_xxx values selecting the parameters to compare
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectParameters::Matches(const AudioObjectParameters& obj, double tolerance, uint_t mask) const
+{
+  uint_t setmask = mask & ((1U << Parameter_count) - 1);
+
+  return (((setbitmap & setmask) == (obj.setbitmap & setmask)) &&
+          ParameterMatches<>(mask, Parameter_channel, values.channel, obj.values.channel) &&
+          ParameterMatches<>(mask, Parameter_duration, values.duration, obj.values.duration) &&
+          ParameterMatches<>(mask, Parameter_cartesian, values.cartesian, obj.values.cartesian) &&
+          PositionMatches(mask, Parameter_position, position, obj.position, tolerance) &&
+          PositionMatches(mask, Parameter_minposition, GetMinPosition(), obj.GetMinPosition(), tolerance) &&
+          PositionMatches(mask, Parameter_maxposition, GetMaxPosition(), obj.GetMaxPosition(), tolerance) &&
+          ParameterMatches<>(mask, Parameter_gain, values.gain, obj.values.gain, tolerance) &&
+          ParameterMatches<>(mask, Parameter_width, values.width, obj.values.width, tolerance) &&
+          ParameterMatches<>(mask, Parameter_height, values.height, obj.values.height, tolerance) &&
+          ParameterMatches<>(mask, Parameter_depth, values.depth, obj.values.depth, tolerance) &&
+          ParameterMatches<>(mask, Parameter_divergencebalance, values.divergencebalance, obj.values.divergencebalance, tolerance) &&
+          ParameterMatches<>(mask, Parameter_divergenceazimuth, values.divergenceazimuth, obj.values.divergenceazimuth, tolerance) &&
+          ParameterMatches<>(mask, Parameter_diffuseness, values.diffuseness, obj.values.diffuseness, tolerance) &&
+          ParameterMatches<>(mask, Parameter_delay, values.delay, obj.values.delay, tolerance) &&
+          ParameterMatches<>(mask, Parameter_objectimportance, values.objectimportance, obj.values.objectimportance) &&
+          ParameterMatches<>(mask, Parameter_channelimportance, values.channelimportance, obj.values.channelimportance) &&
+          ParameterMatches<>(mask, Parameter_dialogue, values.dialogue, obj.values.dialogue) &&
+          ParameterMatches<>(mask, Parameter_channellock, values.channellock, obj.values.channellock) &&
+          ParameterMatches<>(mask, Parameter_channellockmaxdistance, values.channellockmaxdistance, obj.values.channellockmaxdistance, tolerance) &&
+          ParameterMatches<>(mask, Parameter_interact, values.interact, obj.values.interact) &&
+          ParameterMatches<>(mask, Parameter_interpolate, values.interpolate, obj.values.interpolate) &&
+          ParameterMatches<>(mask, Parameter_interpolationtime, values.interpolationtime, obj.values.interpolationtime) &&
+          ParameterMatches<>(mask, Parameter_onscreen, values.onscreen, obj.values.onscreen) &&
+          ParameterMatches<>(mask, Parameter_disableducking, values.disableducking, obj.values.disableducking) &&
+          (!(mask & ParameterMask_othervalues) || (othervalues == obj.othervalues)) &&
+          (!(mask & ParameterMask_excludedzones) || Compare(excludedZones, obj.excludedZones)));
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return which of the selected parameters differ from those of another object
+ *
+ * @param obj object to compare against
+ * @param tolerance maximum absolute difference allowed between numeric values in their own units (see Matches())
+ * @param mask bitwise-OR of ParameterMask_xxx values selecting the parameters to compare
+ *
+ * @return bitwise-OR of ParameterMask_xxx values of the parameters that do not match (0 if all match)
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectParameters::GetDifferences(const AudioObjectParameters& obj, double tolerance, uint_t mask) const
+{
+  uint_t differences = 0;
+
+  // usually nothing has changed so check everything at once first
+  if (!Matches(obj, tolerance, mask))
+  {
+    uint_t bit;
+
+    for (bit = 1; bit && (bit <= (uint_t)ParameterMask_all); bit <<= 1)
+    {
+      if ((mask & bit) && !Matches(obj, tolerance, bit)) differences |= bit;
+    }
+  }
+
+  return differences;
+}
+
 /*--------------------------------------------------------------------------------*/
 /** Merge another AudioObjectParameters into this one
  *
@@ -393,6 +503,55 @@ AudioObjectParameters& AudioObjectParameters::Merge(const AudioObjectParameters&
   return *this;
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Copy selected parameters from another object
+ *
+ * @param obj object to copy from
+ * @param mask bitwise-OR of ParameterMask_xxx values selecting the parameters to copy
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObjectParameters& AudioObjectParameters::CopyParameters(const AudioObjectParameters& obj, uint_t mask)
+{
+  if (&obj != this)
+  {
+    CopyIfSelected<>(obj, mask, Parameter_channel, values.channel, obj.values.channel);
+    CopyIfSelected<>(obj, mask, Parameter_duration, values.duration, obj.values.duration);
+    CopyIfSelected<>(obj, mask, Parameter_cartesian, values.cartesian, obj.values.cartesian);
+    CopyIfSelected<>(obj, mask, Parameter_position, position, obj.position);
+    CopyIfSelected<>(obj, mask, Parameter_minposition, &minposition, obj.GetMinPosition());
+    CopyIfSelected<>(obj, mask, Parameter_maxposition, &maxposition, obj.GetMaxPosition());
+    CopyIfSelected<>(obj, mask, Parameter_gain, values.gain, obj.values.gain);
+    CopyIfSelected<>(obj, mask, Parameter_width, values.width, obj.values.width);
+    CopyIfSelected<>(obj, mask, Parameter_height, values.height, obj.values.height);
+    CopyIfSelected<>(obj, mask, Parameter_depth, values.depth, obj.values.depth);
+    CopyIfSelected<>(obj, mask, Parameter_divergencebalance, values.divergencebalance, obj.values.divergencebalance);
+    CopyIfSelected<>(obj, mask, Parameter_divergenceazimuth, values.divergenceazimuth, obj.values.divergenceazimuth);
+    CopyIfSelected<>(obj, mask, Parameter_diffuseness, values.diffuseness, obj.values.diffuseness);
+    CopyIfSelected<>(obj, mask, Parameter_delay, values.delay, obj.values.delay);
+    CopyIfSelected<>(obj, mask, Parameter_objectimportance, values.objectimportance, obj.values.objectimportance);
+    CopyIfSelected<>(obj, mask, Parameter_channelimportance, values.channelimportance, obj.values.channelimportance);
+    CopyIfSelected<>(obj, mask, Parameter_dialogue, values.dialogue, obj.values.dialogue);
+    CopyIfSelected<>(obj, mask, Parameter_channellock, values.channellock, obj.values.channellock);
+    CopyIfSelected<>(obj, mask, Parameter_channellockmaxdistance, values.channellockmaxdistance, obj.values.channellockmaxdistance);
+    CopyIfSelected<>(obj, mask, Parameter_interact, values.interact, obj.values.interact);
+    CopyIfSelected<>(obj, mask, Parameter_interpolate, values.interpolate, obj.values.interpolate);
+    CopyIfSelected<>(obj, mask, Parameter_interpolationtime, values.interpolationtime, obj.values.interpolationtime);
+    CopyIfSelected<>(obj, mask, Parameter_onscreen, values.onscreen, obj.values.onscreen);
+    CopyIfSelected<>(obj, mask, Parameter_disableducking, values.disableducking, obj.values.disableducking);
+    CopyIfSelected<>(obj, mask, Parameter_othervalues, othervalues, obj.othervalues);
+
+    if (mask & ParameterMask_excludedzones)
+    {
+      // delete current zone(s)
+      ResetExcludedZones();
+      // copy other object's zone(s)
+      if (obj.excludedZones) excludedZones = new ExcludedZone(*obj.excludedZones);
+    }
+  }
+
+  return *this;
+}
+
 /*--------------------------------------------------------------------------------*/
 /** Add a single excluded zone to list
  *
@@ -733,6 +892,460 @@ std::string AudioObjectParameters::ToString(bool pretty) const
   return params.ToString(pretty);
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Append binary representation of parameters to data
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectParameters::ToBinary(std::vector<uint8_t>& data) const
+{
+  AudioObjectBinaryWriter writer(data);
+  const Position *positions[] = {&position, &GetMinPosition(), &GetMaxPosition()};
+  const ExcludedZone *zone;
+  uint8_t polarflags = 0;
+  uint_t  i, j, n;
+
+  writer.Write((uint32_t)setbitmap);
+
+  for (i = 0; i < NUMBEROF(positions); i++)
+  {
+    if (positions[i]->polar) polarflags |= (uint8_t)(1U << i);
+  }
+  writer.Write(polarflags);
+  for (i = 0; i < NUMBEROF(positions); i++)
+  {
+    for (j = 0; j < NUMBEROF(positions[i]->pos.elements); j++) writer.Write(positions[i]->pos.elements[j]);
+  }
+
+  // values are written individually to avoid any dependence on structure packing
+  writer.Write(values.duration);
+  writer.Write(values.interpolationtime);
+  writer.Write(values.gain);
+  writer.Write(values.width);
+  writer.Write(values.height);
+  writer.Write(values.depth);
+  writer.Write(values.diffuseness);
+  writer.Write(values.delay);
+  writer.Write(values.divergenceazimuth);
+  writer.Write(values.divergencebalance);
+  writer.Write(values.channellockmaxdistance);
+  writer.Write((uint32_t)values.channel);
+  writer.Write(values.cartesian);
+  writer.Write(values.objectimportance);
+  writer.Write(values.channelimportance);
+  writer.Write(values.dialogue);
+  writer.Write(values.channellock);
+  writer.Write(values.interact);
+  writer.Write(values.interpolate);
+  writer.Write(values.onscreen);
+  writer.Write(values.disableducking);
+
+  // variable length part: othervalues then excluded zones, each preceded by a count
+  ParameterSet::Iterator it;
+  for (it = othervalues.GetBegin(), n = 0; it != othervalues.GetEnd(); ++it) n++;
+  writer.Write((uint32_t)n);
+  for (it = othervalues.GetBegin(); it != othervalues.GetEnd(); ++it)
+  {
+    writer.Write(it->first);
+    writer.Write(it->second);
+  }
+
+  for (zone = excludedZones, n = 0; zone; zone = zone->GetNext()) n++;
+  writer.Write((uint32_t)n);
+  for (zone = excludedZones; zone; zone = zone->GetNext())
+  {
+    Position mincorner = zone->GetMinCorner();
+    Position maxcorner = zone->GetMaxCorner();
+
+    writer.Write(zone->GetName());
+    for (j = 0; j < NUMBEROF(mincorner.pos.elements); j++) writer.Write((float)mincorner.pos.elements[j]);
+    for (j = 0; j < NUMBEROF(maxcorner.pos.elements); j++) writer.Write((float)maxcorner.pos.elements[j]);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set parameters from binary representation generated by ToBinary()
+ *
+ * @return number of bytes used or 0 if the data is invalid or truncated
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectParameters::FromBinary(const uint8_t *data, uint64_t size)
+{
+  AudioObjectBinaryReader reader(data, size);
+  Position positions[3];
+  uint32_t bitmap = 0, channel = 0, n = 0;
+  uint8_t  polarflags = 0;
+  uint_t   i, j;
+
+  ResetToDefaults();
+
+  reader.Read(bitmap);
+  reader.Read(polarflags);
+  for (i = 0; i < NUMBEROF(positions); i++)
+  {
+    positions[i].polar = ((polarflags & (1U << i)) != 0);
+    for (j = 0; j < NUMBEROF(positions[i].pos.elements); j++) reader.Read(positions[i].pos.elements[j]);
+  }
+
+  reader.Read(values.duration);
+  reader.Read(values.interpolationtime);
+  reader.Read(values.gain);
+  reader.Read(values.width);
+  reader.Read(values.height);
+  reader.Read(values.depth);
+  reader.Read(values.diffuseness);
+  reader.Read(values.delay);
+  reader.Read(values.divergenceazimuth);
+  reader.Read(values.divergencebalance);
+  reader.Read(values.channellockmaxdistance);
+  reader.Read(channel);
+  reader.Read(values.cartesian);
+  reader.Read(values.objectimportance);
+  reader.Read(values.channelimportance);
+  reader.Read(values.dialogue);
+  reader.Read(values.channellock);
+  reader.Read(values.interact);
+  reader.Read(values.interpolate);
+  reader.Read(values.onscreen);
+  reader.Read(values.disableducking);
+  values.channel = channel;
+
+  position = positions[0];
+  if (bitmap & (1U << Parameter_minposition)) SetMinPosition(positions[1]);
+  if (bitmap & (1U << Parameter_maxposition)) SetMaxPosition(positions[2]);
+
+  if (reader.Read(n))
+  {
+    // each entry takes at least 8 bytes so a corrupt count fails quickly below
+    for (i = 0; (i < n) && reader.IsValid(); i++)
+    {
+      std::string name, value;
+
+      if (reader.Read(name) && reader.Read(value)) othervalues.Set(name, value);
+    }
+  }
+
+  if (reader.Read(n))
+  {
+    for (i = 0; (i < n) && reader.IsValid(); i++)
+    {
+      std::string name;
+      float corners[6];
+
+      reader.Read(name);
+      for (j = 0; j < NUMBEROF(corners); j++) reader.Read(corners[j]);
+
+      if (reader.IsValid()) AddExcludedZone(name, corners[0], corners[1], corners[2], corners[3], corners[4], corners[5]);
+    }
+  }
+
+  setbitmap = bitmap;
+
+  if (!reader.IsValid())
+  {
+    BBCERROR("Binary audio object parameters are truncated or invalid");
+    ResetToDefaults();
+  }
+
+  return reader.IsValid() ? (uint_t)reader.GetPosition() : 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append CBOR representation of parameters to data
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectParameters::ToCBOR(std::vector<uint8_t>& data) const
+{
+  AudioObjectCBORWriter writer(data);
+  ToCBOR(writer);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write name of parameter to CBOR writer if it is set
+ *
+ * @return true if the parameter is set (and its value MUST be written)
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectParameters::WriteCBORName(AudioObjectCBORWriter& writer, Parameter_t p) const
+{
+  bool set = IsParameterSet(p);
+  if (set) writer.WriteText(parameterdescs[p].name);
+  return set;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write CBOR representation of parameters
+ *
+ * @param writer CBOR writer
+ * @param extra number of extra key/value pairs to allow for in the map, which the caller MUST write afterwards
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectParameters::ToCBOR(AudioObjectCBORWriter& writer, uint_t extra) const
+{
+  const ExcludedZone *zone;
+  uint_t i, n = extra;
+
+  // only set parameters (and any excluded zones) are written, as ToJSON()
+  for (i = 0; i < Parameter_count; i++)
+  {
+    if (IsParameterSet((Parameter_t)i)) n++;
+  }
+  if (excludedZones) n++;
+
+  writer.WriteMap(n);
+
+  // parameters are written in Parameter_t order
+  if (WriteCBORName(writer, Parameter_channel))                writer.WriteUnsigned(values.channel);
+  if (WriteCBORName(writer, Parameter_duration))               writer.WriteUnsigned(values.duration);
+  if (WriteCBORName(writer, Parameter_cartesian))              writer.WriteBool(values.cartesian != 0);
+  if (WriteCBORName(writer, Parameter_position))               writer.WritePosition(position);
+  if (WriteCBORName(writer, Parameter_minposition))            writer.WritePosition(GetMinPosition());
+  if (WriteCBORName(writer, Parameter_maxposition))            writer.WritePosition(GetMaxPosition());
+  if (WriteCBORName(writer, Parameter_gain))                   writer.WriteDouble(values.gain);
+  if (WriteCBORName(writer, Parameter_width))                  writer.WriteFloat(values.width);
+  if (WriteCBORName(writer, Parameter_height))                 writer.WriteFloat(values.height);
+  if (WriteCBORName(writer, Parameter_depth))                  writer.WriteFloat(values.depth);
+  if (WriteCBORName(writer, Parameter_divergencebalance))      writer.WriteFloat(values.divergencebalance);
+  if (WriteCBORName(writer, Parameter_divergenceazimuth))      writer.WriteFloat(values.divergenceazimuth);
+  if (WriteCBORName(writer, Parameter_diffuseness))            writer.WriteFloat(values.diffuseness);
+  if (WriteCBORName(writer, Parameter_delay))                  writer.WriteFloat(values.delay);
+  if (WriteCBORName(writer, Parameter_objectimportance))       writer.WriteUnsigned(values.objectimportance);
+  if (WriteCBORName(writer, Parameter_channelimportance))      writer.WriteUnsigned(values.channelimportance);
+  if (WriteCBORName(writer, Parameter_dialogue))               writer.WriteUnsigned(values.dialogue);
+  if (WriteCBORName(writer, Parameter_channellock))            writer.WriteBool(values.channellock != 0);
+  if (WriteCBORName(writer, Parameter_channellockmaxdistance)) writer.WriteFloat(values.channellockmaxdistance);
+  if (WriteCBORName(writer, Parameter_interact))               writer.WriteBool(values.interact != 0);
+  if (WriteCBORName(writer, Parameter_interpolate))            writer.WriteBool(values.interpolate != 0);
+  if (WriteCBORName(writer, Parameter_interpolationtime))      writer.WriteUnsigned(values.interpolationtime);
+  if (WriteCBORName(writer, Parameter_onscreen))               writer.WriteBool(values.onscreen != 0);
+  if (WriteCBORName(writer, Parameter_disableducking))         writer.WriteBool(values.disableducking != 0);
+  if (WriteCBORName(writer, Parameter_othervalues))
+  {
+    ParameterSet::Iterator it;
+
+    for (it = othervalues.GetBegin(), n = 0; it != othervalues.GetEnd(); ++it) n++;
+    writer.WriteMap(n);
+    for (it = othervalues.GetBegin(); it != othervalues.GetEnd(); ++it)
+    {
+      writer.WriteText(it->first);
+      writer.WriteText(it->second);
+    }
+  }
+
+  if (excludedZones)
+  {
+    for (zone = excludedZones, n = 0; zone; zone = zone->GetNext()) n++;
+
+    writer.WriteText("excludedzones");
+    writer.WriteArray(n);
+    for (zone = excludedZones; zone; zone = zone->GetNext())
+    {
+      Position c1 = zone->GetMinCorner();
+      Position c2 = zone->GetMaxCorner();
+
+      writer.WriteMap(7);
+      writer.WriteText("name");
+      writer.WriteText(zone->GetName());
+      writer.WriteText("minx");
+      writer.WriteFloat((float)c1.pos.x);
+      writer.WriteText("miny");
+      writer.WriteFloat((float)c1.pos.y);
+      writer.WriteText("minz");
+      writer.WriteFloat((float)c1.pos.z);
+      writer.WriteText("maxx");
+      writer.WriteFloat((float)c2.pos.x);
+      writer.WriteText("maxy");
+      writer.WriteFloat((float)c2.pos.y);
+      writer.WriteText("maxz");
+      writer.WriteFloat((float)c2.pos.z);
+    }
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set parameters from CBOR representation generated by ToCBOR()
+ *
+ * @return number of bytes used or 0 if the data is invalid or truncated
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectParameters::FromCBOR(const uint8_t *data, uint64_t size)
+{
+  AudioObjectCBORReader reader(data, size);
+
+  return FromCBOR(reader) ? (uint_t)reader.GetPosition() : 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set parameters from CBOR representation generated by ToCBOR()
+ *
+ * @return true if the representation was read successfully
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectParameters::FromCBOR(AudioObjectCBORReader& reader)
+{
+  std::string name;
+  uint64_t    i, n;
+
+  ResetToDefaults();
+
+  if (reader.ReadMap(n))
+  {
+    for (i = 0; reader.NextItem(n, i) && reader.ReadText(name); i++)
+    {
+      if (!SetFromCBOR(name, reader)) reader.Skip();
+    }
+  }
+
+  if (!reader.IsValid())
+  {
+    BBCERROR("CBOR audio object parameters are truncated or invalid");
+    ResetToDefaults();
+  }
+
+  return reader.IsValid();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return Parameter_xxx value of parameter name or Parameter_count if name is not a parameter
+ */
+/*--------------------------------------------------------------------------------*/
+static uint_t FindParameter(const std::string& name)
+{
+  typedef std::map<std::string,uint_t> MAP;
+  static const MAP names = []() {
+    std::vector<const PARAMETERDESC *> list;
+    MAP map;
+    uint_t i;
+
+    AudioObjectParameters::GetParameterDescriptions(list);
+    for (i = 0; i < list.size(); i++) map[list[i]->name] = i;
+
+    return map;
+  }();
+  MAP::const_iterator it;
+
+  return ((it = names.find(name)) != names.end()) ? it->second : (uint_t)names.size();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set parameter from the CBOR value of an entry in a map
+ *
+ * @return true if name is a parameter (whose value has been read), false if it is not (the value is NOT read)
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectParameters::SetFromCBOR(const std::string& name, AudioObjectCBORReader& reader)
+{
+  Position pval;
+  uint64_t uval;
+  double   dval;
+  float    fval;
+  bool     bval, known = true;
+
+  switch (FindParameter(name))
+  {
+    case Parameter_channel:                if (reader.ReadUnsigned(uval)) SetChannel((uint_t)uval); break;
+    case Parameter_duration:               if (reader.ReadUnsigned(uval)) SetDuration(uval); break;
+    case Parameter_cartesian:              if (reader.ReadBool(bval)) SetCartesian(bval); break;
+    case Parameter_position:               if (reader.ReadPosition(pval)) SetPosition(pval); break;
+    case Parameter_minposition:            if (reader.ReadPosition(pval)) SetMinPosition(pval); break;
+    case Parameter_maxposition:            if (reader.ReadPosition(pval)) SetMaxPosition(pval); break;
+    case Parameter_gain:                   if (reader.ReadNumber(dval)) SetGain(dval); break;
+    case Parameter_width:                  if (reader.ReadNumber(fval)) SetWidth(fval); break;
+    case Parameter_height:                 if (reader.ReadNumber(fval)) SetHeight(fval); break;
+    case Parameter_depth:                  if (reader.ReadNumber(fval)) SetDepth(fval); break;
+    case Parameter_divergencebalance:      if (reader.ReadNumber(fval)) SetDivergenceBalance(fval); break;
+    case Parameter_divergenceazimuth:      if (reader.ReadNumber(fval)) SetDivergenceAzimuth(fval); break;
+    case Parameter_diffuseness:            if (reader.ReadNumber(fval)) SetDiffuseness(fval); break;
+    case Parameter_delay:                  if (reader.ReadNumber(fval)) SetDelay(fval); break;
+    case Parameter_objectimportance:       if (reader.ReadUnsigned(uval)) SetObjectImportance((uint_t)std::min(uval, (uint64_t)0xff)); break;
+    case Parameter_channelimportance:      if (reader.ReadUnsigned(uval)) SetChannelImportance((uint_t)std::min(uval, (uint64_t)0xff)); break;
+    case Parameter_dialogue:               if (reader.ReadUnsigned(uval)) SetDialogue((uint_t)std::min(uval, (uint64_t)0xff)); break;
+    case Parameter_channellock:            if (reader.ReadBool(bval)) SetChannelLock(bval); break;
+    case Parameter_channellockmaxdistance: if (reader.ReadNumber(fval)) SetChannelLockMaxDistance(fval); break;
+    case Parameter_interact:               if (reader.ReadBool(bval)) SetInteract(bval); break;
+    case Parameter_interpolate:            if (reader.ReadBool(bval)) SetInterpolate(bval); break;
+    case Parameter_interpolationtime:      if (reader.ReadUnsigned(uval)) SetInterpolationTime(uval); break;
+    case Parameter_onscreen:               if (reader.ReadBool(bval)) SetOnScreen(bval); break;
+    case Parameter_disableducking:         if (reader.ReadBool(bval)) SetDisableDucking(bval); break;
+
+    case Parameter_othervalues:
+    {
+      std::string key, value;
+      uint64_t    i, n;
+
+      ResetOtherValues();
+      if (reader.ReadMap(n))
+      {
+        for (i = 0; reader.NextItem(n, i) && reader.ReadText(key) && reader.ReadText(value); i++) SetOtherValue(key, value);
+      }
+      break;
+    }
+
+    default:
+      // support legacy 'importance' parameter name for channel importance (as FromJSON())
+      if (name == "importance")
+      {
+        if (reader.ReadUnsigned(uval)) SetChannelImportance((uint_t)std::min(uval, (uint64_t)0xff));
+      }
+      else if (name == "excludedzones")
+      {
+        uint64_t i, n;
+
+        ResetExcludedZones();
+        if (reader.ReadArray(n))
+        {
+          for (i = 0; reader.NextItem(n, i); i++)
+          {
+            std::string zonename, key;
+            float       corners[6] = {0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+            uint64_t    j, m;
+
+            if (reader.ReadMap(m))
+            {
+              for (j = 0; reader.NextItem(m, j) && reader.ReadText(key); j++)
+              {
+                if      (key == "name") reader.ReadText(zonename);
+                else if (key == "minx") reader.ReadNumber(corners[0]);
+                else if (key == "miny") reader.ReadNumber(corners[1]);
+                else if (key == "minz") reader.ReadNumber(corners[2]);
+                else if (key == "maxx") reader.ReadNumber(corners[3]);
+                else if (key == "maxy") reader.ReadNumber(corners[4]);
+                else if (key == "maxz") reader.ReadNumber(corners[5]);
+                else reader.Skip();
+              }
+            }
+
+            if (reader.IsValid()) AddExcludedZone(zonename, corners[0], corners[1], corners[2], corners[3], corners[4], corners[5]);
+          }
+        }
+      }
+      else known = false;
+      break;
+  }
+
+  return known;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return approximate memory used by this object, including its heap allocations (bytes)
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectParameters::GetMemoryUsage() const
+{
+  const ExcludedZone *zone;
+  ParameterSet::Iterator it;
+  uint_t n = sizeof(*this);
+
+  if (minposition) n += sizeof(*minposition);
+  if (maxposition) n += sizeof(*maxposition);
+
+  // allow for the overhead of each entry in the set
+  for (it = othervalues.GetBegin(); it != othervalues.GetEnd(); ++it) n += (uint_t)(it->first.capacity() + it->second.capacity() + 64);
+
+  for (zone = excludedZones; zone; zone = zone->GetNext()) n += (uint_t)(sizeof(*zone) + zone->GetName().capacity());
+
+  return n;
+}
+
 #if ENABLE_JSON
 /*--------------------------------------------------------------------------------*/
 /** Convert parameters to a JSON object
@@ -959,6 +1572,90 @@ void AudioObjectParameters::Modifier::Modify(AudioObjectParameters& parameters,
   UNUSED_PARAMETER(object);
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Append CBOR representation of modifier to data
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectParameters::Modifier::ToCBOR(std::vector<uint8_t>& data) const
+{
+  AudioObjectCBORWriter writer(data);
+  ToCBOR(writer);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write CBOR representation of modifier (only those parameters that are set, as ToJSON())
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectParameters::Modifier::ToCBOR(AudioObjectCBORWriter& writer) const
+{
+  writer.WriteMap((rotation.IsSet() ? 1 : 0) + (position.IsSet() ? 1 : 0) + (gain.IsSet() ? 1 : 0) + (scale.IsSet() ? 1 : 0));
+  if (rotation.IsSet())
+  {
+    writer.WriteText("rotation");
+    writer.WriteQuaternion(rotation.Get());
+  }
+  if (position.IsSet())
+  {
+    writer.WriteText("position");
+    writer.WritePosition(position.Get());
+  }
+  if (gain.IsSet())
+  {
+    writer.WriteText("gain");
+    writer.WriteDouble(gain.Get());
+  }
+  if (scale.IsSet())
+  {
+    writer.WriteText("scale");
+    writer.WriteDouble(scale.Get());
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set modifier from CBOR representation generated by ToCBOR()
+ *
+ * @return number of bytes used or 0 if the data is invalid or truncated
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectParameters::Modifier::FromCBOR(const uint8_t *data, uint64_t size)
+{
+  AudioObjectCBORReader reader(data, size);
+
+  return FromCBOR(reader) ? (uint_t)reader.GetPosition() : 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set modifier from CBOR representation generated by ToCBOR()
+ *
+ * @return true if the representation was read successfully
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectParameters::Modifier::FromCBOR(AudioObjectCBORReader& reader)
+{
+  std::string name;
+  uint64_t    i, n;
+
+  if (reader.ReadMap(n))
+  {
+    for (i = 0; reader.NextItem(n, i) && reader.ReadText(name); i++)
+    {
+      Quaternion qval;
+      Position   pval;
+      double     dval;
+
+      if      (name == "rotation") {if (reader.ReadQuaternion(qval)) rotation.Set(qval);}
+      else if (name == "position") {if (reader.ReadPosition(pval))   position.Set(pval);}
+      else if (name == "gain")     {if (reader.ReadNumber(dval))     gain.Set(dval);}
+      else if (name == "scale")    {if (reader.ReadNumber(dval))     scale.Set(dval);}
+      else reader.Skip();
+    }
+  }
+
+  if (!reader.IsValid()) BBCERROR("CBOR modifier is truncated or invalid");
+
+  return reader.IsValid();
+}
+
 /*----------------------------------------------------------------------------------------------------*/
 
 /*--------------------------------------------------------------------------------*/
@@ -1013,4 +1710,23 @@ AudioObjectParameters& AudioObjectParameters::Modify(const Modifier::LIST& list,
   return *this;
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Modify this object's parameters using a single modifier
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObjectParameters& AudioObjectParameters::ModifyByHandle(const Modifier& modifier, AudioObject::HANDLE handle)
+{
+  return Modify(modifier, AudioObjectRegistry::Get().Find(handle));
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Modify this object's parameters using a list of modifiers
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObjectParameters& AudioObjectParameters::ModifyByHandle(const Modifier::LIST& list, AudioObject::HANDLE handle)
+{
+  // look object up once for the whole list
+  return Modify(list, list.size() ? AudioObjectRegistry::Get().Find(handle) : NULL);
+}
+
 BBC_AUDIOTOOLBOX_END
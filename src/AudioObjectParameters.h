@@ -1,13 +1,20 @@
 #ifndef __AUDIO_OBJECT_PARAMETERS__
 #define __AUDIO_OBJECT_PARAMETERS__
 
+#include <math.h>
+
 #include <bbcat-base/3DPosition.h>
 #include <bbcat-base/NamedParameter.h>
 #include <bbcat-base/ParameterSet.h>
 #include <bbcat-base/RefCount.h>
 
+#include "AudioObject.h"
+
 BBC_AUDIOTOOLBOX_START
 
+class AudioObjectCBORWriter;
+class AudioObjectCBORReader;
+
 /*--------------------------------------------------------------------------------*/
 /** A class containing the parameters for rendering audio objects
  *
@@ -37,7 +44,6 @@ BBC_AUDIOTOOLBOX_START
  * interpolationLength = interpolate ? interpolationtime : 0
  */
 /*--------------------------------------------------------------------------------*/
-class AudioObject;
 class AudioObjectParameters
 {
 public:
@@ -74,6 +80,36 @@ public:
   virtual bool operator == (const AudioObjectParameters& obj) const;
   virtual bool operator != (const AudioObjectParameters& obj) const {return !operator == (obj);}
 
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether selected parameters match those of another object, allowing a tolerance on numeric values
+   *
+   * @param obj object to compare against
+   * @param tolerance maximum absolute difference allowed between numeric values in their own units
+   * @param mask bitwise-OR of ParameterMask_xxx values selecting the parameters to compare
+   *
+   * @note the selected parameters must be set (or unset) in both objects to match
+   * @note the same tolerance is applied to values in different units: degrees for polar azimuth
+   * and elevation, metres for polar distance, a linear factor for gain and the raw values of
+   * cartesian co-ordinates and the extent, divergence, diffuseness, delay and channel lock
+   * parameters; use mask to compare groups of parameters with different tolerances
+   * @note duration and interpolation time (integer ns) and non-numeric parameters (flags,
+   * othervalues and excluded zones) must match exactly
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Matches(const AudioObjectParameters& obj, double tolerance = 0.0, uint_t mask = ~0U) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return which of the selected parameters differ from those of another object
+   *
+   * @param obj object to compare against
+   * @param tolerance maximum absolute difference allowed between numeric values in their own units (see Matches())
+   * @param mask bitwise-OR of ParameterMask_xxx values selecting the parameters to compare
+   *
+   * @return bitwise-OR of ParameterMask_xxx values of the parameters that do not match (0 if all match)
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetDifferences(const AudioObjectParameters& obj, double tolerance = 0.0, uint_t mask = ParameterMask_all) const;
+
   /*--------------------------------------------------------------------------------*/
   /** Merge another AudioObjectParameters into this one
    *
@@ -435,6 +471,27 @@ public:
   /*--------------------------------------------------------------------------------*/
   bool AnyParametersSet() const {return (setbitmap != 0);}
 
+  /*--------------------------------------------------------------------------------*/
+  /** Copy selected parameters from another object
+   *
+   * @param obj object to copy from
+   * @param mask bitwise-OR of ParameterMask_xxx values selecting the parameters to copy
+   *
+   * @note selected parameters (including whether they are set) are made identical to those in obj,
+   * parameters not selected are left untouched
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObjectParameters& CopyParameters(const AudioObjectParameters& obj, uint_t mask);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Reset all parameters to their defaults
+   *
+   * @note unlike construction, min and max positions are NOT deleted and remain
+   * allocated (but reset) so that the object can be re-used without heap churn
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ResetToDefaults();
+
   /*--------------------------------------------------------------------------------*/
   /** Sub class describing an excluded zone supporting the zoneExclusion ADM parameter
    */
@@ -679,6 +736,86 @@ public:
   /*--------------------------------------------------------------------------------*/
   std::string ToString(bool pretty = false) const;
 
+  /*--------------------------------------------------------------------------------*/
+  /** Append binary representation of parameters to data
+   *
+   * @note the representation is little-endian and independent of structure packing
+   * and consists of a fixed-size part containing the set bitmap, positions and all
+   * values followed by the othervalues and excluded zones
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ToBinary(std::vector<uint8_t>& data) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set parameters from binary representation generated by ToBinary()
+   *
+   * @param data binary data
+   * @param size maximum number of bytes available
+   *
+   * @return number of bytes used or 0 if the data is invalid or truncated
+   *
+   * @note all parameters are replaced; on failure, the parameters are reset
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t FromBinary(const uint8_t *data, uint64_t size);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append CBOR representation of parameters to data
+   *
+   * @note the representation is a map with the same names and structure as ToJSON()
+   * so the two can be converted to one another without loss
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ToCBOR(std::vector<uint8_t>& data) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write CBOR representation of parameters
+   *
+   * @param writer CBOR writer
+   * @param extra number of extra key/value pairs to allow for in the map, which the caller MUST write afterwards
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ToCBOR(AudioObjectCBORWriter& writer, uint_t extra = 0) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set parameters from CBOR representation generated by ToCBOR()
+   *
+   * @param data CBOR data
+   * @param size maximum number of bytes available
+   *
+   * @return number of bytes used or 0 if the data is invalid or truncated
+   *
+   * @note all parameters are replaced (as FromJSON()); on failure, the parameters are reset
+   * @note unknown names are ignored
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t FromCBOR(const uint8_t *data, uint64_t size);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set parameters from CBOR representation generated by ToCBOR()
+   *
+   * @return true if the representation was read successfully
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool FromCBOR(AudioObjectCBORReader& reader);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set parameter from the CBOR value of an entry in a map
+   *
+   * @param name name of entry
+   * @param reader CBOR reader positioned at the value of the entry
+   *
+   * @return true if name is a parameter (whose value has been read), false if it is not (the value is NOT read)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool SetFromCBOR(const std::string& name, AudioObjectCBORReader& reader);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return approximate memory used by this object, including its heap allocations (bytes)
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetMemoryUsage() const;
+
 #if ENABLE_JSON
   /*--------------------------------------------------------------------------------*/
   /** Convert parameters to a JSON object
@@ -755,6 +892,26 @@ public:
     /*--------------------------------------------------------------------------------*/
     virtual void Modify(AudioObjectParameters& parameters, const AudioObject *object = NULL) const;
 
+    /*--------------------------------------------------------------------------------*/
+    /** Append CBOR representation of modifier to data
+     *
+     * @note the representation is a map with the same names and structure as ToJSON()
+     */
+    /*--------------------------------------------------------------------------------*/
+    void ToCBOR(std::vector<uint8_t>& data) const;
+    virtual void ToCBOR(AudioObjectCBORWriter& writer) const;
+
+    /*--------------------------------------------------------------------------------*/
+    /** Set modifier from CBOR representation generated by ToCBOR()
+     *
+     * @return number of bytes used or 0 if the data is invalid or truncated
+     *
+     * @note as FromJSON(), parameters not in the representation are left unchanged
+     */
+    /*--------------------------------------------------------------------------------*/
+    uint_t FromCBOR(const uint8_t *data, uint64_t size);
+    virtual bool FromCBOR(AudioObjectCBORReader& reader);
+
 #if ENABLE_JSON
     /*--------------------------------------------------------------------------------*/
     /** Assignment operator
@@ -805,6 +962,22 @@ public:
   /*--------------------------------------------------------------------------------*/
   AudioObjectParameters& Modify(const Modifier::LIST& list, const AudioObject *object);
 
+  /*--------------------------------------------------------------------------------*/
+  /** Modify this object's parameters using a single modifier
+   *
+   * @param handle handle of audio object (see AudioObjectRegistry), the object is looked up without using its ID
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObjectParameters& ModifyByHandle(const Modifier& modifier, AudioObject::HANDLE handle);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Modify this object's parameters using a list of modifiers
+   *
+   * @param handle handle of audio object (see AudioObjectRegistry), the object is looked up without using its ID
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObjectParameters& ModifyByHandle(const Modifier::LIST& list, AudioObject::HANDLE handle);
+
 protected:
   void GetList(std::vector<INamedParameter *>& list);
   void InitialiseToDefaults();
@@ -853,6 +1026,44 @@ protected:
     Parameter_count,
   } Parameter_t;
 
+public:
+  /*--------------------------------------------------------------------------------*/
+  /** Masks for selecting parameters (see CopyParameters())
+   */
+  /*--------------------------------------------------------------------------------*/
+  enum {
+    ParameterMask_channel                = 1U << Parameter_channel,
+    ParameterMask_duration               = 1U << Parameter_duration,
+    ParameterMask_cartesian              = 1U << Parameter_cartesian,
+    ParameterMask_position               = 1U << Parameter_position,
+    ParameterMask_minposition            = 1U << Parameter_minposition,
+    ParameterMask_maxposition            = 1U << Parameter_maxposition,
+    ParameterMask_gain                   = 1U << Parameter_gain,
+    ParameterMask_width                  = 1U << Parameter_width,
+    ParameterMask_height                 = 1U << Parameter_height,
+    ParameterMask_depth                  = 1U << Parameter_depth,
+    ParameterMask_divergencebalance      = 1U << Parameter_divergencebalance,
+    ParameterMask_divergenceazimuth      = 1U << Parameter_divergenceazimuth,
+    ParameterMask_diffuseness            = 1U << Parameter_diffuseness,
+    ParameterMask_delay                  = 1U << Parameter_delay,
+    ParameterMask_objectimportance       = 1U << Parameter_objectimportance,
+    ParameterMask_channelimportance      = 1U << Parameter_channelimportance,
+    ParameterMask_dialogue               = 1U << Parameter_dialogue,
+    ParameterMask_channellock            = 1U << Parameter_channellock,
+    ParameterMask_channellockmaxdistance = 1U << Parameter_channellockmaxdistance,
+    ParameterMask_interact               = 1U << Parameter_interact,
+    ParameterMask_interpolate            = 1U << Parameter_interpolate,
+    ParameterMask_interpolationtime      = 1U << Parameter_interpolationtime,
+    ParameterMask_onscreen               = 1U << Parameter_onscreen,
+    ParameterMask_disableducking         = 1U << Parameter_disableducking,
+    ParameterMask_othervalues            = 1U << Parameter_othervalues,
+    ParameterMask_excludedzones          = 1U << Parameter_count,    // not a parameter in setbitmap, selects the excluded zones
+
+    ParameterMask_all                    = (1U << (Parameter_count + 1)) - 1,
+  };
+
+protected:
+
   /*--------------------------------------------------------------------------------*/
   /** Return key for screenedgelock parameters stored in 'othervalues'
    */
@@ -1045,6 +1256,25 @@ protected:
     MarkParameterReset(p);
   }
 
+  /*--------------------------------------------------------------------------------*/
+  /** Reset parameter to 'zero' whilst keeping its storage
+   *
+   * Template parameters:
+   * @param T1 type of parameter
+   *
+   * Function parameters:
+   * @param p Parameter_xxx parameter enumeration
+   * @param param ptr to pointer type final destination of value
+   *
+   * @note *param is neither new'd nor deleted by this function
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename T1>
+  void ClearParameter(Parameter_t p, T1 **param) {
+    if (*param) **param = T1();
+    MarkParameterReset(p);
+  }
+
   /*--------------------------------------------------------------------------------*/
   /** Set parameter in ParameterSet from specified parameter
    *
@@ -1416,6 +1646,62 @@ protected:
 	}
   }
 
+  /*--------------------------------------------------------------------------------*/
+  /** Copy parameter and its set state from obj if it is selected by mask
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename T1>
+  void CopyIfSelected(const AudioObjectParameters& obj, uint_t mask, Parameter_t p, T1& dst, const T1& src) {
+    if (mask & (1U << p))
+    {
+      dst = src;
+      MarkParameterSet(p, obj.IsParameterSet(p));
+    }
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Copy parameter and its set state from obj if it is selected by mask (pointer types)
+   *
+   * @note *dst may be new'd as part of this function but is never deleted
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename T1>
+  void CopyIfSelected(const AudioObjectParameters& obj, uint_t mask, Parameter_t p, T1 **dst, const T1& src) {
+    if (mask & (1U << p))
+    {
+      if (obj.IsParameterSet(p))
+      {
+        if (!*dst) *dst = new T1;
+        **dst = src;
+        MarkParameterSet(p);
+      }
+      else ClearParameter<>(p, dst);
+    }
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether parameter is not selected by mask, not set or within tolerance of the value in obj
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename T1>
+  bool ParameterMatches(uint_t mask, Parameter_t p, const T1& a, const T1& b, double tolerance = 0.0) const {
+    return (!(mask & (1U << p)) || !IsParameterSet(p) || (fabs((double)a - (double)b) <= tolerance));
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether position parameter is not selected by mask, not set or within tolerance of the position in obj
+   *
+   * @note tolerance applies to each co-ordinate so is in degrees for azimuth and elevation but metres for distance
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool PositionMatches(uint_t mask, Parameter_t p, const Position& a, const Position& b, double tolerance) const {
+    return (!(mask & (1U << p)) || !IsParameterSet(p) ||
+            ((a.polar == b.polar) &&
+             (fabs(a.pos.x - b.pos.x) <= tolerance) &&
+             (fabs(a.pos.y - b.pos.y) <= tolerance) &&
+             (fabs(a.pos.z - b.pos.z) <= tolerance)));
+  }
+
   /*--------------------------------------------------------------------------------*/
   /** Interpolate to given point between two values if parameter is set
    *
@@ -1500,6 +1786,14 @@ protected:
    */
   /*--------------------------------------------------------------------------------*/
   bool IsParameterSet(Parameter_t p) const {return ((setbitmap & (1U << p)) != 0);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write name of parameter to CBOR writer if it is set
+   *
+   * @return true if the parameter is set (and its value MUST be written)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool WriteCBORName(AudioObjectCBORWriter& writer, Parameter_t p) const;
   
   /*--------------------------------------------------------------------------------*/
   /** Structure of simple data type items
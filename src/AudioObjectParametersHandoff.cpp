@@ -0,0 +1,46 @@
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectParametersHandoff.h"
+
+BBC_AUDIOTOOLBOX_START
+
+AudioObjectParametersHandoff::AudioObjectParametersHandoff() : middle(1),
+                                                               back(2),
+                                                               front(0),
+                                                               valid(false)
+{
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Producer: publish parameters written to GetWriteParameters()
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectParametersHandoff::Publish()
+{
+  // swap back buffer with middle buffer, marking it as new
+  // (release makes the writes to the buffer visible to the consumer, acquire ensures the consumer has finished with the buffer returned)
+  back = middle.exchange(back | NewFlag, std::memory_order_acq_rel) & IndexMask;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Consumer: pick up latest published parameters (if any)
+ *
+ * @return true if new parameters have been picked up
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectParametersHandoff::Update()
+{
+  bool updated = false;
+
+  // only the consumer clears NewFlag so if it is set here it will still be set at the exchange
+  if (middle.load(std::memory_order_acquire) & NewFlag)
+  {
+    front   = middle.exchange(front, std::memory_order_acq_rel) & IndexMask;
+    valid   = true;
+    updated = true;
+  }
+
+  return updated;
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,93 @@
+#ifndef __AUDIO_OBJECT_PARAMETERS_HANDOFF__
+#define __AUDIO_OBJECT_PARAMETERS_HANDOFF__
+
+#include <atomic>
+
+#include "AudioObjectParameters.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Lock-free single-producer/single-consumer handoff of parameters between threads (a triple buffer)
+ *
+ * The producer (e.g. control thread) writes into its own buffer and publishes it by swapping
+ * it with the middle buffer; the consumer (e.g. audio thread) picks up the latest published
+ * buffer by swapping its own buffer with the middle one.  Neither side ever waits for the
+ * other and the consumer always sees a complete set of parameters.  Intermediate updates
+ * published before the consumer picks them up are dropped (only the latest is seen).
+ *
+ * @note exactly ONE thread may call the producer functions and exactly ONE thread may call
+ * the consumer functions
+ * @note all memory allocation (for othervalues, excluded zones, etc.) happens on the producer thread
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectParametersHandoff
+{
+public:
+  AudioObjectParametersHandoff();
+  ~AudioObjectParametersHandoff() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Producer: return parameters to be written before calling Publish()
+   *
+   * @note the contents of the returned object are undefined (they may be from an older update)
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObjectParameters& GetWriteParameters() {return buffers[back];}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Producer: publish parameters written to GetWriteParameters()
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Publish();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Producer: publish a copy of the given parameters
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Write(const AudioObjectParameters& parameters) {buffers[back] = parameters; Publish();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Consumer: pick up latest published parameters (if any)
+   *
+   * @return true if new parameters have been picked up
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Update();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Consumer: return whether any parameters have been picked up
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsValid() const {return valid;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Consumer: return parameters picked up by the last successful Update()
+   *
+   * @note the returned object remains valid and unchanged until the next Update()
+   */
+  /*--------------------------------------------------------------------------------*/
+  const AudioObjectParameters& GetParameters() const {return buffers[front];}
+
+protected:
+  enum {
+    IndexMask = 3,      // bits of middle holding buffer index
+    NewFlag   = 4,      // bit of middle indicating buffer has been published but not picked up
+  };
+
+protected:
+  AudioObjectParameters buffers[3];
+  std::atomic<uint_t>   middle;     // index of middle buffer plus NewFlag
+  uint_t                back;       // index of buffer owned by producer
+  uint_t                front;      // index of buffer owned by consumer
+  bool                  valid;
+
+private:
+  // prevent copying
+  AudioObjectParametersHandoff(const AudioObjectParametersHandoff& obj);
+  AudioObjectParametersHandoff& operator = (const AudioObjectParametersHandoff& obj);
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
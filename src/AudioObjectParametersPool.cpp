@@ -0,0 +1,83 @@
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectParametersPool.h"
+
+BBC_AUDIOTOOLBOX_START
+
+AudioObjectParametersPool::AudioObjectParametersPool() : maxfree(64)
+{
+  freelist.reserve(maxfree);
+}
+
+AudioObjectParametersPool::~AudioObjectParametersPool()
+{
+  SetMaxFree(0);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return pool for the calling thread
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObjectParametersPool& AudioObjectParametersPool::Get()
+{
+  static thread_local AudioObjectParametersPool pool;
+  return pool;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return an object reset to its defaults
+ *
+ * @note object MUST be returned using Release()
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObjectParameters *AudioObjectParametersPool::Acquire()
+{
+  AudioObjectParameters *parameters;
+
+  if (freelist.size())
+  {
+    // objects are reset as they are released so can be handed out directly
+    parameters = freelist.back();
+    freelist.pop_back();
+  }
+  else parameters = new AudioObjectParameters;
+
+  return parameters;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return an object to the pool
+ *
+ * @note if the pool is full, the object will be deleted
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectParametersPool::Release(AudioObjectParameters *parameters)
+{
+  if (parameters)
+  {
+    if (freelist.size() < maxfree)
+    {
+      parameters->ResetToDefaults();
+      freelist.push_back(parameters);
+    }
+    else delete parameters;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set maximum number of free objects kept by the pool
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectParametersPool::SetMaxFree(uint_t n)
+{
+  maxfree = n;
+
+  // delete any objects over the new limit
+  while (freelist.size() > maxfree)
+  {
+    delete freelist.back();
+    freelist.pop_back();
+  }
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,98 @@
+#ifndef __AUDIO_OBJECT_PARAMETERS_POOL__
+#define __AUDIO_OBJECT_PARAMETERS_POOL__
+
+#include <vector>
+
+#include "AudioObjectParameters.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** A per-thread pool of re-usable AudioObjectParameters objects
+ *
+ * Constructing an AudioObjectParameters object initialises every parameter and
+ * deletes any allocated min/max positions and zones.  Objects obtained from this
+ * pool are instead reset using ResetToDefaults() which keeps any previous
+ * allocations so that temporaries used every block (e.g. for GetObjectParameters()
+ * or Interpolate() destinations) cause no heap churn once the pool is warm.
+ *
+ * Each thread has its own pool (see Get()) so no locking is required
+ *
+ * @note objects should be released back to the pool of the thread that acquired them
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectParametersPool
+{
+public:
+  /*--------------------------------------------------------------------------------*/
+  /** Return pool for the calling thread
+   */
+  /*--------------------------------------------------------------------------------*/
+  static AudioObjectParametersPool& Get();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return an object reset to its defaults
+   *
+   * @note object MUST be returned using Release()
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObjectParameters *Acquire();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return an object to the pool
+   *
+   * @note if the pool is full, the object will be deleted
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Release(AudioObjectParameters *parameters);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set/Get maximum number of free objects kept by the pool
+   */
+  /*--------------------------------------------------------------------------------*/
+  void   SetMaxFree(uint_t n);
+  uint_t GetMaxFree() const {return maxfree;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of free objects currently in the pool
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetFreeCount() const {return (uint_t)freelist.size();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Scoped holder of a pooled object, returned to the pool on destruction
+   */
+  /*--------------------------------------------------------------------------------*/
+  class Handle
+  {
+  public:
+    Handle() : pool(AudioObjectParametersPool::Get()),
+               parameters(pool.Acquire()) {}
+    ~Handle() {pool.Release(parameters);}
+
+    AudioObjectParameters& operator * ()  const {return *parameters;}
+    AudioObjectParameters *operator -> () const {return parameters;}
+    AudioObjectParameters *Get()          const {return parameters;}
+
+  private:
+    // prevent copying
+    Handle(const Handle& obj);
+    Handle& operator = (const Handle& obj);
+
+  protected:
+    AudioObjectParametersPool& pool;
+    AudioObjectParameters      *parameters;
+  };
+
+protected:
+  AudioObjectParametersPool();
+  ~AudioObjectParametersPool();
+
+protected:
+  std::vector<AudioObjectParameters *> freelist;
+  uint_t                               maxfree;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -0,0 +1,227 @@
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectRegistry.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Register object with AudioObjectRegistry, assigning it a handle
+ *
+ * @return handle for this object's ID
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObject::HANDLE AudioObject::Register()
+{
+  // remove any previous registration (the ID may have changed)
+  Unregister();
+  return (handle = AudioObjectRegistry::Get().Register(this));
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove object from AudioObjectRegistry
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObject::Unregister()
+{
+  if (handle)
+  {
+    AudioObjectRegistry::Get().Unregister(handle, this);
+    handle = 0;
+  }
+}
+
+/*----------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** Return global registry
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObjectRegistry& AudioObjectRegistry::Get()
+{
+  // deliberately never deleted so that static audio objects can unregister during program exit
+  static AudioObjectRegistry *registry = new AudioObjectRegistry;
+  return *registry;
+}
+
+AudioObjectRegistry::AudioObjectRegistry() : count(0)
+{
+  uint_t i;
+
+  for (i = 0; i < MaxChunks; i++) chunks[i] = NULL;
+}
+
+AudioObjectRegistry::~AudioObjectRegistry()
+{
+  uint_t i;
+
+  for (i = 0; i < MaxChunks; i++) delete[] chunks[i].load();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return handle for ID, creating one if necessary
+ *
+ * @return handle or 0 if the registry is full
+ *
+ * @note lock MUST be held
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObject::HANDLE AudioObjectRegistry::InternLocked(const std::string& id)
+{
+  HANDLEMAP::iterator it;
+  AudioObject::HANDLE handle = 0;
+
+  if ((it = handles.find(id)) != handles.end()) handle = it->second;
+  else
+  {
+    uint_t n = count.load(std::memory_order_relaxed);
+
+    if (n < ((uint_t)MaxChunks << ChunkBits))
+    {
+      ENTRY *chunk = chunks[n >> ChunkBits].load(std::memory_order_relaxed);
+
+      // chunks are allocated as required and never moved or freed
+      if (!chunk)
+      {
+        chunk = new ENTRY[ChunkSize];
+        chunks[n >> ChunkBits].store(chunk, std::memory_order_release);
+      }
+
+      // new ID, initialise entry for it before publishing the handle
+      handle = (AudioObject::HANDLE)(n + 1);
+      it     = handles.insert(HANDLEMAP::value_type(id, handle)).first;
+
+      ENTRY& entry = chunk[n & (ChunkSize - 1)];
+      entry.id = &it->first;
+      entry.object.store(NULL, std::memory_order_relaxed);
+
+      count.store(n + 1, std::memory_order_release);
+
+      BBCDEBUG3(("Interned '%s' as handle %u", id.c_str(), handle));
+    }
+    else BBCERROR("Failed to intern '%s', registry is full", id.c_str());
+  }
+
+  return handle;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return entry for handle or NULL if handle is invalid
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObjectRegistry::ENTRY *AudioObjectRegistry::GetEntry(AudioObject::HANDLE handle) const
+{
+  ENTRY *entry = NULL;
+
+  // the acquire of count makes the entry (and its chunk) visible
+  if (handle && (handle <= count.load(std::memory_order_acquire)))
+  {
+    uint_t n = handle - 1;
+    entry = chunks[n >> ChunkBits].load(std::memory_order_acquire) + (n & (ChunkSize - 1));
+  }
+
+  return entry;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return handle for ID, creating one if necessary
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObject::HANDLE AudioObjectRegistry::Intern(const std::string& id)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  return InternLocked(id);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return handle for ID or 0 if ID is not known
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObject::HANDLE AudioObjectRegistry::GetHandle(const std::string& id) const
+{
+  std::lock_guard<std::mutex> guard(lock);
+  HANDLEMAP::const_iterator it;
+  return ((it = handles.find(id)) != handles.end()) ? it->second : 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return ID for handle (empty string for invalid handles)
+ */
+/*--------------------------------------------------------------------------------*/
+std::string AudioObjectRegistry::GetID(AudioObject::HANDLE handle) const
+{
+  const ENTRY *entry = GetEntry(handle);
+  return entry ? *entry->id : std::string();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Register object against the handle of its ID
+ *
+ * @return handle
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObject::HANDLE AudioObjectRegistry::Register(AudioObject *obj)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  AudioObject::HANDLE handle = InternLocked(obj->GetID());
+  ENTRY *entry;
+
+  if ((entry = GetEntry(handle)) != NULL)
+  {
+    AudioObject *prev = entry->object.exchange(obj, std::memory_order_acq_rel);
+
+    if (prev && (prev != obj))
+    {
+      BBCDEBUG2(("Object '%s' replaces previous object with the same ID", obj->GetID().c_str()));
+    }
+  }
+
+  return handle;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove object from handle (if it is the object currently registered with it)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectRegistry::Unregister(AudioObject::HANDLE handle, const AudioObject *obj)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  ENTRY *entry;
+
+  if (((entry = GetEntry(handle)) != NULL) && (entry->object.load(std::memory_order_relaxed) == obj))
+  {
+    // the ID stays interned so the handle remains valid for that ID
+    entry->object.store(NULL, std::memory_order_release);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return object registered with handle or NULL
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObject *AudioObjectRegistry::Find(AudioObject::HANDLE handle) const
+{
+  const ENTRY *entry = GetEntry(handle);
+  return entry ? entry->object.load(std::memory_order_acquire) : NULL;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return object registered with ID or NULL
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObject *AudioObjectRegistry::Find(const std::string& id) const
+{
+  std::lock_guard<std::mutex> guard(lock);
+  HANDLEMAP::const_iterator it;
+  return ((it = handles.find(id)) != handles.end()) ? GetEntry(it->second)->object.load(std::memory_order_relaxed) : NULL;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return number of interned IDs
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectRegistry::GetCount() const
+{
+  return count.load(std::memory_order_acquire);
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,136 @@
+#ifndef __AUDIO_OBJECT_REGISTRY__
+#define __AUDIO_OBJECT_REGISTRY__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+#include "AudioObject.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Global registry mapping audio object IDs to integer handles and handles to objects
+ *
+ * Each distinct ID is interned once and given a handle which never changes, so
+ * objects with the same ID always have the same handle.  Looking up an object by
+ * handle is a simple array index, the ID hash is only needed when an object is
+ * registered or looked up by ID.
+ *
+ * Entries are allocated in chunks which are never moved or freed so looking up
+ * an object or ID by handle is lock-free; the lock is only taken to intern IDs,
+ * register and unregister objects and look up by ID.
+ *
+ * All functions are thread-safe
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectRegistry
+{
+public:
+  /*--------------------------------------------------------------------------------*/
+  /** Return global registry
+   */
+  /*--------------------------------------------------------------------------------*/
+  static AudioObjectRegistry& Get();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return handle for ID, creating one if necessary
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObject::HANDLE Intern(const std::string& id);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return handle for ID or 0 if ID is not known
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObject::HANDLE GetHandle(const std::string& id) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return ID for handle (empty string for invalid handles)
+   */
+  /*--------------------------------------------------------------------------------*/
+  std::string GetID(AudioObject::HANDLE handle) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Register object against the handle of its ID
+   *
+   * @return handle
+   *
+   * @note any object previously registered with the same ID is replaced
+   * @note normally called via AudioObject::Register()
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObject::HANDLE Register(AudioObject *obj);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove object from handle (if it is the object currently registered with it)
+   *
+   * @note normally called via AudioObject::Unregister()
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Unregister(AudioObject::HANDLE handle, const AudioObject *obj);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return object registered with handle or NULL
+   *
+   * @note lock-free so can be used by many render threads at once
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObject *Find(AudioObject::HANDLE handle) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return object registered with ID or NULL
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObject *Find(const std::string& id) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of interned IDs
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetCount() const;
+
+protected:
+  AudioObjectRegistry();
+  ~AudioObjectRegistry();
+
+  typedef struct {
+    const std::string         *id;      // points to key in handles (stable across rehashes)
+    std::atomic<AudioObject *> object;
+  } ENTRY;
+
+  AudioObject::HANDLE InternLocked(const std::string& id);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return entry for handle or NULL if handle is invalid
+   *
+   * @note lock-free
+   */
+  /*--------------------------------------------------------------------------------*/
+  ENTRY *GetEntry(AudioObject::HANDLE handle) const;
+
+  enum {
+    ChunkBits = 12,
+    ChunkSize = 1 << ChunkBits,         // entries per chunk
+    MaxChunks = 4096,                   // maximum of 16M IDs
+  };
+
+protected:
+  typedef std::unordered_map<std::string, AudioObject::HANDLE> HANDLEMAP;
+
+  mutable std::mutex   lock;
+  HANDLEMAP            handles;
+  std::atomic<ENTRY *> chunks[MaxChunks];  // entry for handle h is chunks[(h - 1) >> ChunkBits][(h - 1) & (ChunkSize - 1)]
+  std::atomic<uint_t>  count;              // number of interned IDs, published after the entry is initialised
+
+private:
+  // prevent copying
+  AudioObjectRegistry(const AudioObjectRegistry& obj);
+  AudioObjectRegistry& operator = (const AudioObjectRegistry& obj);
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
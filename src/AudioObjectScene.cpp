@@ -0,0 +1,338 @@
+
+#include <algorithm>
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectScene.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Return parameters of object n or NULL if the object is not set
+ */
+/*--------------------------------------------------------------------------------*/
+const AudioObjectParameters *AudioObjectScene::Snapshot::Get(uint_t n) const
+{
+  const CHUNK  *chunk  = (n < count) ? chunks[n / ChunkSize] : NULL;       // chunks that have never been written are NULL
+  const OBJECT *object = chunk ? chunk->objects[n % ChunkSize] : NULL;
+  return object ? &object->parameters : NULL;
+}
+
+AudioObjectScene::AudioObjectScene(uint_t _maxreaders) : current(new Snapshot),
+                                                         epoch(1),
+                                                         readerepochs(new std::atomic<uint64_t>[_maxreaders]),
+                                                         readersused(_maxreaders, false),
+                                                         maxreaders(_maxreaders),
+                                                         count(0)
+{
+  uint_t i;
+
+  for (i = 0; i < maxreaders; i++) readerepochs[i].store(0);
+}
+
+AudioObjectScene::~AudioObjectScene()
+{
+  uint_t i;
+
+  // all readers must have finished by now
+  for (i = 0; i < retired.size(); i++) DeleteSnapshot(retired[i].snapshot);
+  DeleteSnapshot(current.load());
+
+  for (i = 0; i < changes.size(); i++)
+  {
+    if (changes[i].object) ReleaseObject(changes[i].object);
+  }
+
+  delete[] readerepochs;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Register calling thread as a reader
+ *
+ * @return reader slot or -1 if all slots are in use
+ */
+/*--------------------------------------------------------------------------------*/
+sint_t AudioObjectScene::RegisterReader()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  uint_t i;
+
+  for (i = 0; i < maxreaders; i++)
+  {
+    if (!readersused[i])
+    {
+      readersused[i] = true;
+      return (sint_t)i;
+    }
+  }
+
+  BBCERROR("No free reader slots in scene (maximum %u readers)", maxreaders);
+
+  return -1;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Unregister reader slot
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectScene::UnregisterReader(uint_t reader)
+{
+  std::lock_guard<std::mutex> guard(lock);
+
+  if (reader < maxreaders)
+  {
+    readerepochs[reader].store(0);
+    readersused[reader] = false;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Reader: acquire current snapshot (wait-free)
+ *
+ * @return snapshot that remains valid until Release() is called
+ */
+/*--------------------------------------------------------------------------------*/
+const AudioObjectScene::Snapshot *AudioObjectScene::Acquire(uint_t reader)
+{
+  // announce the epoch *before* reading the snapshot pointer (both sequentially consistent):
+  // any snapshot replaced before the epoch was read cannot be returned below and any snapshot
+  // replaced afterwards is retired with an epoch at least as late as the one announced
+  readerepochs[reader].store(epoch.load());
+  return current.load();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Reader: release snapshot acquired by Acquire()
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectScene::Release(uint_t reader)
+{
+  readerepochs[reader].store(0, std::memory_order_release);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Writer: set number of object slots in scene (from next Publish())
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectScene::SetCount(uint_t n)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  count = n;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Writer: stage new parameters for object n (visible from next Publish())
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectScene::Set(uint_t n, const AudioObjectParameters& parameters)
+{
+  // copy outside of lock
+  OBJECT *object = new OBJECT;
+  CHANGE change;
+
+  object->parameters = parameters;
+  object->refs       = 1;
+
+  change.n      = n;
+  change.object = object;
+
+  std::lock_guard<std::mutex> guard(lock);
+  changes.push_back(change);
+  count = std::max(count, n + 1);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Writer: stage removal of object n (visible from next Publish())
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectScene::Remove(uint_t n)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  CHANGE change;
+
+  change.n      = n;
+  change.object = NULL;
+  changes.push_back(change);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Writer: publish all staged changes as a new snapshot and free unused old snapshots
+ *
+ * @return version of current snapshot
+ */
+/*--------------------------------------------------------------------------------*/
+uint64_t AudioObjectScene::Publish()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  const Snapshot *oldsnapshot = current.load(std::memory_order_relaxed);    // only writers change current
+
+  if (changes.size() || (count != oldsnapshot->count))
+  {
+    Snapshot *snapshot = new Snapshot;
+    uint_t   nchunks = (count + ChunkSize - 1) / ChunkSize;
+    std::vector<bool> copied(nchunks, false);       // true for chunks that are new to this snapshot
+    uint_t   i;
+
+    snapshot->version = oldsnapshot->version + 1;
+    snapshot->count   = count;
+    snapshot->chunks.resize(nchunks, NULL);
+
+    // share existing chunks
+    for (i = 0; (i < nchunks) && (i < oldsnapshot->chunks.size()); i++)
+    {
+      if ((snapshot->chunks[i] = oldsnapshot->chunks[i]) != NULL) snapshot->chunks[i]->refs++;
+    }
+
+    // objects beyond the new end of the last (shared) chunk must be removed
+    for (i = count; (i < (nchunks * ChunkSize)) && (i < oldsnapshot->count); i++)
+    {
+      CHANGE change;
+
+      change.n      = i;
+      change.object = NULL;
+      changes.push_back(change);
+    }
+
+    for (i = 0; i < changes.size(); i++)
+    {
+      const CHANGE& change = changes[i];
+
+      // objects staged beyond the (possibly reduced) count are discarded
+      if ((change.n >= count) && change.object)
+      {
+        ReleaseObject(change.object);
+      }
+      else if (change.n < (nchunks * ChunkSize))
+      {
+        uint_t c = change.n / ChunkSize;
+        CHUNK  *chunk;
+
+        if (!copied[c])
+        {
+          // copy-on-write: create new chunk referencing the same objects as the shared one
+          CHUNK *oldchunk = snapshot->chunks[c];
+          uint_t j;
+
+          chunk = new CHUNK;
+          chunk->refs = 1;
+          for (j = 0; j < ChunkSize; j++)
+          {
+            if ((chunk->objects[j] = oldchunk ? oldchunk->objects[j] : NULL) != NULL) chunk->objects[j]->refs++;
+          }
+
+          if (oldchunk) ReleaseChunk(oldchunk);
+
+          snapshot->chunks[c] = chunk;
+          copied[c] = true;
+        }
+        else chunk = snapshot->chunks[c];
+
+        OBJECT *& object = chunk->objects[change.n % ChunkSize];
+        if (object) ReleaseObject(object);
+        object = change.object;       // reference passes to chunk
+      }
+    }
+    changes.clear();
+
+    // publish new snapshot then retire the old one with the epoch in which it was replaced
+    current.store(snapshot);
+
+    RETIRED old;
+    old.snapshot = oldsnapshot;
+    old.epoch    = epoch.fetch_add(1);
+    retired.push_back(old);
+
+    BBCDEBUG3(("Published scene version %u (%u objects, %u chunks copied)", (uint_t)snapshot->version, snapshot->count, (uint_t)std::count(copied.begin(), copied.end(), true)));
+  }
+
+  ReclaimLocked();
+
+  return current.load(std::memory_order_relaxed)->version;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Writer: free old snapshots that are no longer held by any reader
+ *
+ * @return number of old snapshots still waiting to be freed
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectScene::Reclaim()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  return ReclaimLocked();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Reclaim old snapshots (mutex MUST be held)
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectScene::ReclaimLocked()
+{
+  if (retired.size())
+  {
+    uint64_t oldest = epoch.load();
+    uint_t   i, n = 0;
+
+    // find earliest epoch in which any active reader acquired its snapshot
+    for (i = 0; i < maxreaders; i++)
+    {
+      uint64_t readerepoch = readerepochs[i].load();
+      if (readerepoch) oldest = std::min(oldest, readerepoch);
+    }
+
+    // a snapshot retired during epoch e may be held by readers that announced epoch e or earlier
+    for (i = 0; i < retired.size(); i++)
+    {
+      if (retired[i].epoch < oldest) DeleteSnapshot(retired[i].snapshot);
+      else retired[n++] = retired[i];
+    }
+    retired.resize(n);
+  }
+
+  return (uint_t)retired.size();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Release reference to object, deleting it when unreferenced (mutex MUST be held)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectScene::ReleaseObject(OBJECT *object)
+{
+  if (!--object->refs) delete object;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Release reference to chunk, deleting it (and releasing its objects) when unreferenced (mutex MUST be held)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectScene::ReleaseChunk(CHUNK *chunk)
+{
+  if (!--chunk->refs)
+  {
+    uint_t i;
+
+    for (i = 0; i < ChunkSize; i++)
+    {
+      if (chunk->objects[i]) ReleaseObject(chunk->objects[i]);
+    }
+
+    delete chunk;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Delete snapshot, releasing its chunks (mutex MUST be held)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectScene::DeleteSnapshot(const Snapshot *snapshot)
+{
+  uint_t i;
+
+  for (i = 0; i < snapshot->chunks.size(); i++)
+  {
+    if (snapshot->chunks[i]) ReleaseChunk(snapshot->chunks[i]);
+  }
+
+  delete snapshot;
+}
+
+BBC_AUDIOTOOLBOX_END
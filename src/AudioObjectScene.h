@@ -0,0 +1,217 @@
+#ifndef __AUDIO_OBJECT_SCENE__
+#define __AUDIO_OBJECT_SCENE__
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "AudioObjectParameters.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** A live scene of audio object parameters shared between one or more writers and many concurrent readers
+ *
+ * The scene is published as a series of immutable, versioned snapshots:
+ * - readers Acquire() the current snapshot wait-free (no locks, no loops) and Release() it when done
+ * - writers stage changes with Set()/Remove() and make them visible with Publish(); writers are
+ *   serialised by a mutex that readers never take
+ * - snapshots share unchanged objects in chunks, so publishing only copies the chunks containing
+ *   changed objects (plus a small array of chunk pointers)
+ * - retired snapshots are freed (epoch-based reclamation) once no reader that could hold them remains
+ *
+ * Each reader thread must register for a reader slot with RegisterReader() and use that slot
+ * for Acquire() and Release()
+ *
+ * @note all freeing happens on writer threads (in Publish() and Reclaim())
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectScene
+{
+public:
+  AudioObjectScene(uint_t _maxreaders = 16);
+  ~AudioObjectScene();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Number of objects in each shared chunk
+   */
+  /*--------------------------------------------------------------------------------*/
+  enum {
+    ChunkSize = 32,
+  };
+
+  /*--------------------------------------------------------------------------------*/
+  /** An immutable view of the scene
+   */
+  /*--------------------------------------------------------------------------------*/
+  class Snapshot
+  {
+  public:
+    /*--------------------------------------------------------------------------------*/
+    /** Return version number of snapshot (incremented on each publish)
+     */
+    /*--------------------------------------------------------------------------------*/
+    uint64_t GetVersion() const {return version;}
+
+    /*--------------------------------------------------------------------------------*/
+    /** Return number of object slots in scene
+     */
+    /*--------------------------------------------------------------------------------*/
+    uint_t GetCount() const {return count;}
+
+    /*--------------------------------------------------------------------------------*/
+    /** Return parameters of object n or NULL if the object is not set
+     */
+    /*--------------------------------------------------------------------------------*/
+    const AudioObjectParameters *Get(uint_t n) const;
+
+  protected:
+    friend class AudioObjectScene;
+
+    Snapshot() : version(0), count(0) {}
+    ~Snapshot() {}
+
+    /*--------------------------------------------------------------------------------*/
+    /** Reference counted parameters (references only counted by writers)
+     */
+    /*--------------------------------------------------------------------------------*/
+    typedef struct {
+      AudioObjectParameters parameters;
+      uint_t                refs;
+    } OBJECT;
+
+    /*--------------------------------------------------------------------------------*/
+    /** Reference counted chunk of objects (references only counted by writers)
+     */
+    /*--------------------------------------------------------------------------------*/
+    typedef struct {
+      OBJECT *objects[ChunkSize];
+      uint_t refs;
+    } CHUNK;
+
+  protected:
+    uint64_t            version;
+    uint_t              count;
+    std::vector<CHUNK *> chunks;
+  };
+
+  /*--------------------------------------------------------------------------------*/
+  /** Register calling thread as a reader
+   *
+   * @return reader slot or -1 if all slots are in use
+   */
+  /*--------------------------------------------------------------------------------*/
+  sint_t RegisterReader();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Unregister reader slot
+   *
+   * @note the reader MUST NOT be holding a snapshot
+   */
+  /*--------------------------------------------------------------------------------*/
+  void UnregisterReader(uint_t reader);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Reader: acquire current snapshot (wait-free)
+   *
+   * @param reader reader slot from RegisterReader()
+   *
+   * @return snapshot that remains valid until Release() is called
+   *
+   * @note a reader may only hold one snapshot at a time
+   */
+  /*--------------------------------------------------------------------------------*/
+  const Snapshot *Acquire(uint_t reader);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Reader: release snapshot acquired by Acquire()
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Release(uint_t reader);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Writer: set number of object slots in scene (from next Publish())
+   */
+  /*--------------------------------------------------------------------------------*/
+  void SetCount(uint_t n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Writer: stage new parameters for object n (visible from next Publish())
+   *
+   * @note the number of object slots is extended if necessary
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Set(uint_t n, const AudioObjectParameters& parameters);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Writer: stage removal of object n (visible from next Publish())
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Remove(uint_t n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Writer: publish all staged changes as a new snapshot and free unused old snapshots
+   *
+   * @return version of current snapshot
+   *
+   * @note if nothing has changed, no new snapshot is published
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t Publish();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Writer: free old snapshots that are no longer held by any reader
+   *
+   * @return number of old snapshots still waiting to be freed
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Reclaim();
+
+protected:
+  typedef Snapshot::OBJECT OBJECT;
+  typedef Snapshot::CHUNK  CHUNK;
+
+  typedef struct {
+    const Snapshot *snapshot;
+    uint64_t        epoch;        // epoch during which snapshot was replaced
+  } RETIRED;
+
+  typedef struct {
+    uint_t n;
+    OBJECT *object;               // NULL to remove object
+  } CHANGE;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Reclaim old snapshots (mutex MUST be held)
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t ReclaimLocked();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Release references to objects, chunks and snapshots, deleting them when unreferenced (mutex MUST be held)
+   */
+  /*--------------------------------------------------------------------------------*/
+  static void ReleaseObject(OBJECT *object);
+  static void ReleaseChunk(CHUNK *chunk);
+  static void DeleteSnapshot(const Snapshot *snapshot);
+
+protected:
+  std::mutex                     lock;          // writer lock
+  std::atomic<const Snapshot *>  current;
+  std::atomic<uint64_t>          epoch;
+  std::atomic<uint64_t>          *readerepochs; // epoch in which each reader acquired its snapshot, 0 if none
+  std::vector<bool>              readersused;
+  std::vector<RETIRED>           retired;
+  std::vector<CHANGE>            changes;
+  uint_t                         maxreaders;
+  uint_t                         count;
+
+private:
+  // prevent copying
+  AudioObjectScene(const AudioObjectScene& obj);
+  AudioObjectScene& operator = (const AudioObjectScene& obj);
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -0,0 +1,301 @@
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectStreamingCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Maximum number of evicted objects kept for re-use
+ */
+/*--------------------------------------------------------------------------------*/
+static const uint_t MaxPoolSize = 64;
+
+AudioObjectStreamingCursor::AudioObjectStreamingCursor(AudioObjectBlockCursor *_source, uint64_t _budget, uint_t _blocksbehind) : AudioObjectBlockCursor(_source->GetChannel(), _source->GetAudioObject()),
+                                                                                                                                  source(_source),
+                                                                                                                                  budget(_budget),
+                                                                                                                                  memory(0),
+                                                                                                                                  generation(0),
+                                                                                                                                  misscount(0),
+                                                                                                                                  firstblock(0),
+                                                                                                                                  blocksbehind(_blocksbehind),
+                                                                                                                                  quit(false)
+{
+  // the source's index is used directly rather than copied (see GetBlockStart())
+  endtime = source->GetEndTime();
+
+  pool.reserve(MaxPoolSize);
+
+  // the current block must always be in the window so that GetCurrentObjectParameters() never
+  // returns the object shared by blocks outside the window
+  if (GetBlockCount())
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    DecodeCurrentBlock(guard);
+  }
+
+  thread = std::thread(&AudioObjectStreamingCursor::DecodeThread, this);
+}
+
+AudioObjectStreamingCursor::~AudioObjectStreamingCursor()
+{
+  uint_t i;
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    quit = true;
+  }
+  wake.notify_all();
+  thread.join();
+
+  for (i = 0; i < window.size(); i++) delete window[i].parameters;
+  for (i = 0; i < pool.size(); i++) delete pool[i];
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set memory budget for decoded blocks (bytes)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectStreamingCursor::SetMemoryBudget(uint64_t bytes)
+{
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    budget = bytes;
+  }
+  wake.notify_one();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return memory currently used by decoded blocks in the window (bytes)
+ */
+/*--------------------------------------------------------------------------------*/
+uint64_t AudioObjectStreamingCursor::GetMemoryUsed() const
+{
+  std::lock_guard<std::mutex> guard(lock);
+  return memory;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return number of blocks currently in the window
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectStreamingCursor::GetWindowSize() const
+{
+  std::lock_guard<std::mutex> guard(lock);
+  return (uint_t)window.size();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Copy block n from source
+ *
+ * @return true if block is valid
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectStreamingCursor::CopyBlock(uint_t n, AudioObjectParameters& parameters) const
+{
+  std::lock_guard<std::mutex> guard(sourcelock);
+  const AudioObjectParameters *blockparameters;
+  bool valid = false;
+
+  if ((blockparameters = source->GetBlockParameters(n)) != NULL)
+  {
+    parameters = *blockparameters;
+    valid      = true;
+  }
+
+  return valid;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Move all blocks before block n out of the window (lock MUST be held)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectStreamingCursor::EvictBefore(uint_t n)
+{
+  while (window.size() && (firstblock < n))
+  {
+    const ENTRY& entry = window.front();
+
+    if (entry.parameters) pool.push_back(entry.parameters);
+    memory -= entry.memory;
+
+    window.pop_front();
+    firstblock++;
+  }
+
+  if (firstblock < n)
+  {
+    // window is empty, any block being decoded is no longer wanted
+    firstblock = n;
+    generation++;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Restart window at block n (lock MUST be held)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectStreamingCursor::RestartWindow(uint_t n)
+{
+  EvictBefore(firstblock + (uint_t)window.size());
+
+  firstblock = n;
+  generation++;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Decode current block synchronously into the empty window rather than waiting for the decode thread
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectStreamingCursor::DecodeCurrentBlock(std::unique_lock<std::mutex>& guard)
+{
+  AudioObjectParameters *parameters = NULL;
+  uint64_t gen;
+
+  if (pool.size())
+  {
+    parameters = pool.back();
+    pool.pop_back();
+  }
+  gen = generation;
+
+  guard.unlock();
+  if (!parameters) parameters = new AudioObjectParameters;
+  bool valid = CopyBlock(blockindex, *parameters);
+  guard.lock();
+
+  // the decode thread may have added the block in the meantime
+  if ((gen == generation) && window.empty() && (firstblock == blockindex))
+  {
+    ENTRY entry;
+
+    entry.parameters = valid ? parameters : NULL;
+    entry.memory     = valid ? parameters->GetMemoryUsage() : 0;
+    window.push_back(entry);
+    memory += entry.memory;
+
+    if (!valid) pool.push_back(parameters);
+  }
+  else pool.push_back(parameters);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Seek cursor to specified time (ns), evicting blocks behind the current block
+ *
+ * @return true if the current block changed
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectStreamingCursor::Seek(uint64_t t)
+{
+  bool changed = AudioObjectBlockCursor::Seek(t);
+
+  if (changed)
+  {
+    std::unique_lock<std::mutex> guard(lock);
+
+    // within the window: evict blocks behind, otherwise start again at the current block
+    if ((blockindex >= firstblock) && (blockindex < (firstblock + window.size())))
+    {
+      EvictBefore((blockindex > blocksbehind) ? blockindex - blocksbehind : 0);
+    }
+    else RestartWindow(blockindex);
+
+    if (window.empty())
+    {
+      misscount++;
+      DecodeCurrentBlock(guard);
+    }
+
+    guard.unlock();
+    wake.notify_one();
+  }
+
+  return changed;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return parameters of block n or NULL if n is out of range or the block is invalid
+ */
+/*--------------------------------------------------------------------------------*/
+const AudioObjectParameters *AudioObjectStreamingCursor::GetBlockParameters(uint_t n) const
+{
+  if (n < GetBlockCount())
+  {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      // blocks in the window are only evicted by Seek()
+      if ((n >= firstblock) && (n < (firstblock + window.size()))) return window[n - firstblock].parameters;
+    }
+
+    misscount++;
+
+    if (CopyBlock(n, missparameters)) return &missparameters;
+  }
+
+  return NULL;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Background decode thread
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectStreamingCursor::DecodeThread()
+{
+  std::unique_lock<std::mutex> guard(lock);
+  uint_t nblocks = GetBlockCount();
+
+  while (!quit)
+  {
+    uint_t next = firstblock + (uint_t)window.size();
+
+    // always decode up to the block after the current one, then up to the budget
+    if ((next < nblocks) && ((memory < budget) || (next <= (firstblock + blocksbehind + 1))))
+    {
+      AudioObjectParameters *parameters = NULL;
+      uint64_t gen = generation;
+
+      if (pool.size())
+      {
+        parameters = pool.back();
+        pool.pop_back();
+      }
+
+      guard.unlock();
+      if (!parameters) parameters = new AudioObjectParameters;
+      bool valid = CopyBlock(next, *parameters);
+      guard.lock();
+
+      // the window may have moved whilst decoding
+      if ((gen == generation) && (next == (firstblock + window.size())))
+      {
+        ENTRY entry;
+
+        entry.parameters = valid ? parameters : NULL;
+        entry.memory     = valid ? parameters->GetMemoryUsage() : 0;
+        window.push_back(entry);
+        memory += entry.memory;
+
+        if (!valid)
+        {
+          BBCERROR("Failed to decode block %u of channel %u", next, channel);
+          pool.push_back(parameters);
+        }
+      }
+      else pool.push_back(parameters);
+    }
+    else if (pool.size() > MaxPoolSize)
+    {
+      // free excess evicted objects outside of the lock
+      std::vector<AudioObjectParameters *> excess(pool.begin() + MaxPoolSize, pool.end());
+      uint_t i;
+
+      pool.resize(MaxPoolSize);
+
+      guard.unlock();
+      for (i = 0; i < excess.size(); i++) delete excess[i];
+      guard.lock();
+    }
+    else wake.wait(guard);
+  }
+}
+
+BBC_AUDIOTOOLBOX_END
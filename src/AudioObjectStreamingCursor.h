@@ -0,0 +1,165 @@
+#ifndef __AUDIO_OBJECT_STREAMING_CURSOR__
+#define __AUDIO_OBJECT_STREAMING_CURSOR__
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AudioObjectBlockCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** A cursor that keeps only a sliding window of decoded blocks of a source cursor around the play head
+ *
+ * A background thread copies blocks from the source cursor (e.g. an AudioObjectTimelineFileCursor
+ * or AudioObjectLazyJSONCursor, which decode on demand) ahead of the current block until the
+ * memory used by the window reaches the memory budget.  Blocks behind the current block are
+ * evicted as the cursor moves (the current block and a configurable number of blocks before it
+ * are kept) and their objects are re-used for later blocks.  Memory use is therefore bounded
+ * by the budget regardless of the length of the timeline.
+ *
+ * If a requested block is not in the window (e.g. just after a seek to a different part of
+ * the timeline), it is copied from the source synchronously and the window restarted from the
+ * current block.
+ *
+ * @note the source cursor is NOT owned and MUST NOT be used by anything else (including being
+ * modified) whilst this cursor exists
+ * @note apart from construction and destruction, this cursor's functions must only be called
+ * from one thread at a time (as with other cursors)
+ * @note at least the current block and the next are always decoded regardless of the budget
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectStreamingCursor : public AudioObjectBlockCursor
+{
+public:
+  /*--------------------------------------------------------------------------------*/
+  /** Constructor
+   *
+   * @param _source source cursor (NOT owned)
+   * @param _budget memory budget for decoded blocks (bytes)
+   * @param _blocksbehind number of blocks before the current block to keep
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObjectStreamingCursor(AudioObjectBlockCursor *_source, uint64_t _budget = 4 * 1024 * 1024, uint_t _blocksbehind = 1);
+  virtual ~AudioObjectStreamingCursor();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Seek cursor to specified time (ns), evicting blocks behind the current block
+   *
+   * @return true if the current block changed
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool Seek(uint64_t t);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of blocks, start time of block n and index of block current at time t from the source's index
+   *
+   * @note these only read the source's index (which does not change) so do not need the source lock
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint_t   GetBlockCount() const {return source->GetBlockCount();}
+  virtual uint64_t GetBlockStart(uint_t n) const {return source->GetBlockStart(n);}
+  virtual uint_t   FindBlock(uint64_t t) const {return source->FindBlock(t);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return parameters of block n or NULL if n is out of range or the block is invalid
+   *
+   * @note the returned object is owned by the cursor and only remains valid until the
+   * cursor is next seeked or this function is next called for a block outside the window
+   * (the current block is always in the window)
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual const AudioObjectParameters *GetBlockParameters(uint_t n) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set/Get memory budget for decoded blocks (bytes)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void     SetMemoryBudget(uint64_t bytes);
+  uint64_t GetMemoryBudget() const {return budget;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return memory currently used by decoded blocks in the window (bytes)
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetMemoryUsed() const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of blocks currently in the window
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetWindowSize() const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of requests for blocks outside the window (which were decoded synchronously)
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetMissCount() const {return misscount;}
+
+protected:
+  typedef struct {
+    AudioObjectParameters *parameters;    // NULL if block is invalid
+    uint_t                memory;
+  } ENTRY;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Background decode thread
+   */
+  /*--------------------------------------------------------------------------------*/
+  void DecodeThread();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Move all blocks before block n out of the window (lock MUST be held)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void EvictBefore(uint_t n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Restart window at block n (lock MUST be held)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void RestartWindow(uint_t n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Decode current block synchronously into the empty window (lock MUST be held, it is released whilst decoding)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void DecodeCurrentBlock(std::unique_lock<std::mutex>& guard);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Copy block n from source (source lock MUST NOT be held)
+   *
+   * @return true if block is valid
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool CopyBlock(uint_t n, AudioObjectParameters& parameters) const;
+
+protected:
+  AudioObjectBlockCursor             *source;
+  mutable std::mutex                 lock;          // protects the window, pool and counters
+  mutable std::mutex                 sourcelock;    // serialises access to the source
+  std::condition_variable            wake;
+  std::thread                        thread;
+  std::deque<ENTRY>                  window;        // decoded blocks from block firstblock onwards
+  std::vector<AudioObjectParameters *> pool;        // evicted objects for re-use
+  mutable AudioObjectParameters      missparameters;
+  uint64_t                           budget;
+  uint64_t                           memory;
+  uint64_t                           generation;    // incremented when the window is restarted
+  mutable uint64_t                   misscount;
+  uint_t                             firstblock;
+  uint_t                             blocksbehind;
+  bool                               quit;
+
+private:
+  // prevent copying
+  AudioObjectStreamingCursor(const AudioObjectStreamingCursor& obj);
+  AudioObjectStreamingCursor& operator = (const AudioObjectStreamingCursor& obj);
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -0,0 +1,309 @@
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <atomic>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectTimelineCache.h"
+#include "AudioObjectTimelineCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+AudioObjectTimelineCache::AudioObjectTimelineCache() : fromcache(false)
+{
+}
+
+AudioObjectTimelineCache::~AudioObjectTimelineCache()
+{
+  Clear();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Delete all cursors and close cache
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineCache::Clear()
+{
+  uint_t i;
+
+  // cursors must be deleted before the file they may refer to is closed
+  for (i = 0; i < cursors.size(); i++) delete cursors[i];
+  cursors.clear();
+
+  file.Close();
+  fromcache = false;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return 64-bit FNV-1a hash of data
+ */
+/*--------------------------------------------------------------------------------*/
+uint64_t AudioObjectTimelineCache::Hash(const uint8_t *data, uint64_t size, uint64_t hash)
+{
+  uint64_t i;
+
+  for (i = 0; i < size; i++)
+  {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return size and modification time of file
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineCache::GetFileInfo(const std::string& filename, SOURCEKEY& key)
+{
+  struct stat st;
+  bool success = false;
+
+  if (stat(filename.c_str(), &st) == 0)
+  {
+    key.size  = (uint64_t)st.st_size;
+    key.mtime = (uint64_t)st.st_mtime;
+    key.hash  = 0;
+    success   = true;
+  }
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read entire contents of file
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineCache::ReadFile(const std::string& filename, std::string& text)
+{
+  FILE *fp;
+  bool success = false;
+
+  text.clear();
+
+  if ((fp = fopen(filename.c_str(), "rb")) != NULL)
+  {
+    char   buf[65536];
+    size_t n;
+
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) text.append(buf, n);
+
+    success = !ferror(fp);
+    fclose(fp);
+  }
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return size and hash of contents of file without keeping the contents
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineCache::HashFile(const std::string& filename, SOURCEKEY& key)
+{
+  FILE *fp;
+  bool success = false;
+
+  key.size = 0;
+  key.hash = Hash(NULL, 0);
+
+  if ((fp = fopen(filename.c_str(), "rb")) != NULL)
+  {
+    uint8_t buf[65536];
+    size_t  n;
+
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+      key.hash  = Hash(buf, n, key.hash);
+      key.size += n;
+    }
+
+    success = !ferror(fp);
+    fclose(fp);
+  }
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Load timelines from source file, using the cache if it is up to date
+ *
+ * @return true if timelines were loaded
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineCache::Load(const std::string& filename, bool writecache)
+{
+  std::string cachefilename = GetCacheFilename(filename);
+  SOURCEKEY   key, cachekey, hashkey;
+  bool        success = false;
+
+  Clear();
+
+  if (!GetFileInfo(filename, key))
+  {
+    BBCERROR("Failed to read timeline source '%s'", filename.c_str());
+    return false;
+  }
+
+  // only try the cache if it exists (to avoid errors) and was generated from the same source:
+  // the size and modification time are checked first so that the source is only read and
+  // hashed when the cache is likely to be valid
+  if (GetFileInfo(cachefilename, cachekey) &&
+      file.Open(cachefilename) &&
+      file.GetSourceKey(cachekey) &&
+      (cachekey.size  == key.size) &&
+      (cachekey.mtime == key.mtime) &&
+      HashFile(filename, hashkey) &&
+      (cachekey.size  == hashkey.size) &&
+      (cachekey.hash  == hashkey.hash))
+  {
+    if ((success = LoadCache()))
+    {
+      BBCDEBUG3(("Loaded %u timelines of '%s' from cache", GetCursorCount(), filename.c_str()));
+      fromcache = true;
+    }
+    else Clear();
+  }
+  else file.Close();
+
+  if (!success)
+  {
+    std::string text;
+
+    if (!ReadFile(filename, text))
+    {
+      BBCERROR("Failed to read timeline source '%s'", filename.c_str());
+      return false;
+    }
+
+    if ((success = Parse(text, cursors)))
+    {
+      BBCDEBUG3(("Parsed %u timelines from '%s'", GetCursorCount(), filename.c_str()));
+
+      if (writecache)
+      {
+        // the file may have changed since it was stat'ed, the key must describe what was read
+        key.size = text.size();
+        key.hash = Hash((const uint8_t *)text.data(), text.size());
+
+        WriteCache(cachefilename, key);
+      }
+    }
+    else
+    {
+      BBCERROR("Failed to parse timeline source '%s'", filename.c_str());
+      Clear();
+    }
+  }
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Create cursors from cache
+ *
+ * @return true if all cursors were created
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineCache::LoadCache()
+{
+  uint_t i, n = file.GetChannelCount();
+  bool   success = true;
+
+  for (i = 0; success && (i < n); i++)
+  {
+    AudioObjectBlockCursor *cursor;
+
+    if ((cursor = file.CreateCursor(i)) != NULL) cursors.push_back(cursor);
+    else success = false;
+  }
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write cursors to cache
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineCache::WriteCache(const std::string& filename, const SOURCEKEY& key) const
+{
+  std::vector<const AudioObjectBlockCursor *> list(cursors.begin(), cursors.end());
+  static std::atomic<uint_t> tempcount(0);
+  std::string tempfilename = filename + "." + StringFrom((uint_t)getpid()) + "." + StringFrom((uint_t)tempcount++) + ".tmp";
+  bool success;
+
+  // write to a temporary file unique to this writer (process and call) and rename so that
+  // readers never see a partial cache and concurrent writers never write to the same file
+  if ((success = AudioObjectTimelineFile::Write(tempfilename, list, &key)))
+  {
+#ifdef _WIN32
+    remove(filename.c_str());
+#endif
+    success = (rename(tempfilename.c_str(), filename.c_str()) == 0);
+  }
+
+  if (!success)
+  {
+    BBCERROR("Failed to write timeline cache '%s'", filename.c_str());
+    remove(tempfilename.c_str());
+  }
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Create cursors from text of source file
+ *
+ * @return true if source was parsed successfully
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineCache::Parse(const std::string& text, std::vector<AudioObjectBlockCursor *>& list)
+{
+  bool success = false;
+
+#if ENABLE_JSON
+  json_spirit::mValue value;
+
+  if (json_spirit::read(text, value))
+  {
+    if (value.type() == json_spirit::obj_type)
+    {
+      AudioObjectTimelineCursor *cursor = new AudioObjectTimelineCursor(0);
+
+      list.push_back(cursor);
+      success = cursor->FromJSON(value.get_obj());
+    }
+    else if (value.type() == json_spirit::array_type)
+    {
+      const json_spirit::mArray& array = value.get_array();
+      uint_t i;
+
+      success = true;
+      for (i = 0; success && (i < array.size()); i++)
+      {
+        AudioObjectTimelineCursor *cursor = new AudioObjectTimelineCursor(i);
+
+        list.push_back(cursor);
+        success = ((array[i].type() == json_spirit::obj_type) && cursor->FromJSON(array[i].get_obj()));
+      }
+    }
+  }
+#else
+  UNUSED_PARAMETER(text);
+  UNUSED_PARAMETER(list);
+  BBCERROR("Parsing timelines requires JSON support");
+#endif
+
+  return success;
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,142 @@
+#ifndef __AUDIO_OBJECT_TIMELINE_CACHE__
+#define __AUDIO_OBJECT_TIMELINE_CACHE__
+
+#include <string>
+#include <vector>
+
+#include "AudioObjectTimelineFile.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Loads timelines from a (JSON) source file using a binary cache of the parsed timelines
+ * stored next to the source file
+ *
+ * The cache is an AudioObjectTimelineFile whose header holds the key (size, modification time
+ * and content hash) of the source it was generated from.  When the key of the source matches,
+ * the timelines are read from the cache, otherwise the source is parsed and the cache re-written.
+ *
+ * The source is either a single JSON object as generated by AudioObjectCursor::ToJSON() (channel 0)
+ * or a JSON array of such objects (channel = array index).  Other formats can be supported by
+ * overriding Parse().
+ *
+ * @note cursors are owned by this object and remain valid until the next Load() or Clear()
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectTimelineCache
+{
+public:
+  AudioObjectTimelineCache();
+  virtual ~AudioObjectTimelineCache();
+
+  typedef AudioObjectTimelineFile::SOURCEKEY SOURCEKEY;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Load timelines from source file, using the cache if it is up to date
+   *
+   * @param filename source file
+   * @param writecache true to (re-)write the cache if the source had to be parsed
+   *
+   * @return true if timelines were loaded
+   *
+   * @note failure to write the cache is not an error
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Load(const std::string& filename, bool writecache = true);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Delete all cursors and close cache
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Clear();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether the last Load() used the cache
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsFromCache() const {return fromcache;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of cursors (channels) loaded
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetCursorCount() const {return (uint_t)cursors.size();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return nth cursor or NULL
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObjectBlockCursor *GetCursor(uint_t n) const {return (n < cursors.size()) ? cursors[n] : NULL;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return name of cache file of source file
+   */
+  /*--------------------------------------------------------------------------------*/
+  static std::string GetCacheFilename(const std::string& filename) {return filename + ".tlcache";}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return 64-bit FNV-1a hash of data
+   *
+   * @param hash hash of previous data to continue from
+   */
+  /*--------------------------------------------------------------------------------*/
+  static uint64_t Hash(const uint8_t *data, uint64_t size, uint64_t hash = 14695981039346656037ULL);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read entire contents of file
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool ReadFile(const std::string& filename, std::string& text);
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Create cursors from text of source file
+   *
+   * @param text contents of source file
+   * @param list list to be populated with new cursors (owned by this object)
+   *
+   * @return true if source was parsed successfully
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool Parse(const std::string& text, std::vector<AudioObjectBlockCursor *>& list);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return size and modification time of file
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool GetFileInfo(const std::string& filename, SOURCEKEY& key);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return size and hash of contents of file without keeping the contents
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool HashFile(const std::string& filename, SOURCEKEY& key);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Create cursors from cache
+   *
+   * @return true if all cursors were created
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool LoadCache();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write cursors to cache
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool WriteCache(const std::string& filename, const SOURCEKEY& key) const;
+
+protected:
+  AudioObjectTimelineFile               file;
+  std::vector<AudioObjectBlockCursor *> cursors;
+  bool                                  fromcache;
+
+private:
+  // prevent copying
+  AudioObjectTimelineCache(const AudioObjectTimelineCache& obj);
+  AudioObjectTimelineCache& operator = (const AudioObjectTimelineCache& obj);
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
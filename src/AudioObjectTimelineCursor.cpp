@@ -0,0 +1,454 @@
+
+#include <math.h>
+
+#include <algorithm>
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectTimelineCursor.h"
+#include "AudioObjectCBOR.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Add a block of parameters starting at time t (ns)
+ *
+ * @note if a block already starts at t, it is replaced
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineCursor::Add(uint64_t t, const AudioObjectParameters& parameters)
+{
+  uint_t n = GetBlockCount();
+
+  // blocks are normally added in time order so check the end first
+  if (n && (blockstarts[n - 1] > t)) n = FindBlock(t) + ((blockstarts[0] <= t) ? 1 : 0);
+
+  if (n && (blockstarts[n - 1] == t))
+  {
+    // replace existing block
+    uint64_t oldend = t + blocks[n - 1].GetDuration();
+    blocks[n - 1] = parameters;
+    UpdateBlockEnd(n - 1, oldend);
+  }
+  else
+  {
+    blocks.insert(blocks.begin() + n, parameters);
+    InsertBlock(n, t, parameters.GetDuration());
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove all blocks
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineCursor::Clear()
+{
+  blocks.clear();
+  ClearBlocks();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** End last block at time t (ns)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineCursor::EndLastBlock(uint64_t t)
+{
+  uint_t n = GetBlockCount();
+
+  if (n && (t > blockstarts[n - 1]))
+  {
+    uint64_t oldend = blockstarts[n - 1] + blocks[n - 1].GetDuration();
+    blocks[n - 1].SetDuration(t - blockstarts[n - 1]);
+    UpdateBlockEnd(n - 1, oldend);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Update end time after the end of block n has changed from oldend
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineCursor::UpdateBlockEnd(uint_t n, uint64_t oldend)
+{
+  uint64_t end = blockstarts[n] + blocks[n].GetDuration();
+
+  if ((end < oldend) && (oldend >= endtime))
+  {
+    // block was shortened and may have been the one ending last so find the new last end
+    uint_t i;
+
+    endtime = 0;
+    for (i = 0; i < blocks.size(); i++) UpdateEndTime(blockstarts[i], blocks[i].GetDuration());
+  }
+  else UpdateEndTime(blockstarts[n], blocks[n].GetDuration());
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Record audio object parameters at the current time (i.e. the time of the last Seek())
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineCursor::SetObjectParameters(const AudioObjectParameters& newparameters)
+{
+  uint_t n = GetBlockCount();
+  uint64_t t = seektime;
+
+  // recording normally happens at or after the start of the last block, anything else is simply inserted
+  if (n && (t >= blockstarts[n - 1]))
+  {
+    // end previous block here whether it is to be extended or followed by a new block
+    EndLastBlock(t);
+
+    if (mergeblocks && blocks[n - 1].Matches(newparameters, mergetolerance, AudioObjectParameters::ParameterMask_all & ~AudioObjectParameters::ParameterMask_duration))
+    {
+      BBCDEBUG3(("Merging parameters at %lu into block %u", (ulong_t)t, n - 1));
+    }
+    else if (newparameters.IsDurationSet())
+    {
+      // new block lasts until it is ended
+      AudioObjectParameters parameters = newparameters;
+      parameters.ResetDuration();
+      Add(t, parameters);
+    }
+    else Add(t, newparameters);
+  }
+  else Add(t, newparameters);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** End recording by ending the last block at the current time
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineCursor::EndChanges()
+{
+  EndLastBlock(seektime);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return rendering of block n from block previous (previous == n for the first block) ending at end
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObjectTimelineCursor::RENDERSEGMENT AudioObjectTimelineCursor::GetRenderSegment(uint_t previous, uint_t n, uint64_t end) const
+{
+  RENDERSEGMENT segment;
+
+  segment.previous = previous;
+  segment.n        = n;
+  segment.start    = blockstarts[n];
+  segment.end      = end;
+  // as AudioObjectBlockPipeline::Prepare(), the first block has nothing to interpolate from
+  segment.rampend  = (previous != n) ? std::min(segment.start + blocks[n].GetActualInterpolationTime(), end) : segment.start;
+
+  return segment;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return end of rendering of block n in the original timeline
+ */
+/*--------------------------------------------------------------------------------*/
+uint64_t AudioObjectTimelineCursor::GetRenderEnd(uint_t n) const
+{
+  // the last block holds its parameters forever after its interpolation
+  return ((n + 1) < blockstarts.size()) ? blockstarts[n + 1] : blockstarts[n] + blocks[n].GetActualInterpolationTime();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Render segment at time t (start <= t <= end) using keys
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineCursor::Render(const RENDERSEGMENT& segment, uint64_t t, const std::vector<AudioObjectParameters>& keys, AudioObjectParameters& parameters)
+{
+  // as AudioObjectBlockPipeline::GetInterpolationMul(): mul = 1 at the start of the interpolation, 0 at its end
+  double mul = (t < segment.rampend) ? (double)(segment.rampend - t) / (double)(segment.rampend - segment.start) : 0.0;
+
+  AudioObjectParameters::Interpolate(parameters, mul, keys[segment.previous], keys[segment.n]);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return whether the positions and gains of parameters1 and parameters2 are within tolerances
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineCursor::IsWithinTolerances(const AudioObjectParameters& parameters1, const AudioObjectParameters& parameters2, const THINNINGTOLERANCES& tolerances)
+{
+  const Position& pos1 = parameters1.GetPosition();
+  // compare in the co-ordinate system of the first
+  Position pos2 = pos1.polar ? parameters2.GetPosition().Polar() : parameters2.GetPosition().Cart();
+  bool within;
+
+  if (pos1.polar)
+  {
+    double daz = fmod(fabs(pos1.pos.az - pos2.pos.az), 360.0);
+
+    within = ((std::min(daz, 360.0 - daz)      <= tolerances.angle) &&
+              (fabs(pos1.pos.el - pos2.pos.el) <= tolerances.angle) &&
+              (fabs(pos1.pos.d  - pos2.pos.d)  <= tolerances.distance));
+  }
+  else
+  {
+    double dx = pos1.pos.x - pos2.pos.x, dy = pos1.pos.y - pos2.pos.y, dz = pos1.pos.z - pos2.pos.z;
+
+    within = (sqrt(dx * dx + dy * dy + dz * dz) <= tolerances.distance);
+  }
+
+  if (within)
+  {
+    // compare gains in dB (limiting to -200dB to handle zero gains)
+    double gain1 = 20.0 * log10(std::max(fabs(parameters1.GetGain()), 1.0e-10));
+    double gain2 = 20.0 * log10(std::max(fabs(parameters2.GetGain()), 1.0e-10));
+
+    within = (fabs(gain1 - gain2) <= tolerances.gain);
+  }
+
+  return within;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return whether the renderings of segments 1 and 2 are within tolerances where they overlap
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineCursor::IsRenderedWithin(const RENDERSEGMENT& segment1, const RENDERSEGMENT& segment2, const std::vector<AudioObjectParameters>& keys, AudioObjectParameters& rendered1, AudioObjectParameters& rendered2, const THINNINGTOLERANCES& tolerances)
+{
+  uint64_t start = std::max(segment1.start, segment2.start);
+  uint64_t end   = std::min(segment1.end,   segment2.end);
+  bool     within = true;
+
+  // segments that only touch are compared by their neighbours
+  if (start < end)
+  {
+    // the renderings are linear between these points so the errors are largest at one of them
+    // (distances are convex and dB differences monotonic between the points)
+    uint64_t points[] = {start, end, segment1.rampend, segment2.rampend};
+    uint_t i;
+
+    for (i = 0; within && (i < NUMBEROF(points)); i++)
+    {
+      if ((points[i] >= start) && (points[i] <= end))
+      {
+        Render(segment1, points[i], keys, rendered1);
+        Render(segment2, points[i], keys, rendered2);
+        within = IsWithinTolerances(rendered1, rendered2, tolerances);
+      }
+    }
+  }
+
+  return within;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return whether blocks between blocks a and c can be removed, given that block p is the block before a after thinning
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineCursor::CanRemove(uint_t p, uint_t a, uint_t c, uint_t first, const std::vector<AudioObjectParameters>& keys, AudioObjectParameters& rendered1, AudioObjectParameters& rendered2, const THINNINGTOLERANCES& tolerances) const
+{
+  // after thinning, block a lasts until block c which then interpolates from block a
+  RENDERSEGMENT thinned[] = {GetRenderSegment(p, a, blockstarts[c]), GetRenderSegment(a, c, GetRenderEnd(c))};
+  bool ok = true;
+  uint_t i, j;
+
+  // everything except position and gain (and timing) of removed blocks must match block a exactly
+  for (i = std::max(first, a + 1); ok && (i < c); i++)
+  {
+    ok = blocks[a].Matches(blocks[i], 0.0, (AudioObjectParameters::ParameterMask_all &
+                                            ~(AudioObjectParameters::ParameterMask_position |
+                                              AudioObjectParameters::ParameterMask_gain |
+                                              AudioObjectParameters::ParameterMask_duration |
+                                              AudioObjectParameters::ParameterMask_interpolationtime)));
+  }
+
+  // compare original rendering of blocks first to c with the thinned rendering
+  for (i = first; ok && (i <= c); i++)
+  {
+    RENDERSEGMENT original = GetRenderSegment(i ? i - 1 : i, i, GetRenderEnd(i));
+
+    for (j = 0; ok && (j < NUMBEROF(thinned)); j++) ok = IsRenderedWithin(original, thinned[j], keys, rendered1, rendered2, tolerances);
+  }
+
+  return ok;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove blocks whose removal changes the rendered position and gain by no more than tolerances
+ *
+ * @return number of blocks removed
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectTimelineCursor::Thin(const THINNINGTOLERANCES& tolerances)
+{
+  uint_t n = GetBlockCount();
+  uint_t removed = 0;
+
+  if (n > 2)
+  {
+    std::vector<AudioObjectParameters> keys(n);
+    AudioObjectParameters rendered1, rendered2;
+    std::vector<bool> keep(n, false);
+    uint_t p = 0, a = 0, i, j;
+
+    // only positions and gains are rendered so avoid copying anything else during rendering
+    for (i = 0; i < n; i++)
+    {
+      keys[i].CopyParameters(blocks[i], AudioObjectParameters::ParameterMask_position | AudioObjectParameters::ParameterMask_gain);
+    }
+
+    keep[0] = keep[n - 1] = true;
+
+    // greedily extend the span from anchor block a until the first failure (or the maximum span)
+    while (a < (n - 1))
+    {
+      uint_t c = a + 1, first = a;
+
+      while (((c + 1) < n) && ((c + 1 - a) <= MaxThinningSpan) && CanRemove(p, a, c + 1, first, keys, rendered1, rendered2, tolerances))
+      {
+        c++;
+
+        // once block a's interpolation has finished before block c, extending the span further leaves
+        // the rendering before c unchanged so only blocks from c onwards need checking
+        if ((blockstarts[a] + blocks[a].GetActualInterpolationTime()) <= blockstarts[c]) first = c;
+      }
+
+      keep[c] = true;
+      p = a;
+      a = c;
+    }
+
+    // compact blocks, extending durations of remaining blocks to cover removed ones
+    // (interpolation times are left alone, CanRemove() has already allowed for them)
+    for (i = j = a = 0; i < n; i++)
+    {
+      if (keep[i])
+      {
+        // a is original index of previous block kept
+        if ((i > (a + 1)) && blocks[j - 1].IsDurationSet()) blocks[j - 1].SetDuration(blockstarts[i] - blockstarts[j - 1]);
+
+        if (i != j)
+        {
+          blocks[j]      = blocks[i];
+          blockstarts[j] = blockstarts[i];
+        }
+        a = i;
+        j++;
+      }
+    }
+
+    removed = n - j;
+    blocks.resize(j);
+    blockstarts.resize(j);
+
+    // current block may have moved
+    blockindex = FindBlock(seektime);
+
+    BBCDEBUG2(("Thinned %u blocks to %u", n, j));
+  }
+
+  return removed;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Replace blocks with those in a CBOR array as generated by ToCBOR()
+ *
+ * @return number of bytes used or 0 if the data is invalid or truncated
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectTimelineCursor::FromCBOR(const uint8_t *data, uint64_t size)
+{
+  AudioObjectCBORReader              reader(data, size);
+  std::vector<AudioObjectParameters> decoded;
+  std::vector<uint64_t>              starts;
+  std::string name;
+  uint64_t    i, n, t = 0;
+
+  // blocks are decoded before any are replaced so that invalid data leaves the cursor unchanged
+  if (reader.ReadArray(n))
+  {
+    // each block takes at least one byte
+    if (n <= size)
+    {
+      decoded.reserve((size_t)n);
+      starts.reserve((size_t)n);
+    }
+
+    for (i = 0; reader.NextItem(n, i); i++)
+    {
+      uint64_t j, m;
+
+      decoded.push_back(AudioObjectParameters());
+
+      AudioObjectParameters& parameters = decoded.back();
+      if (reader.ReadMap(m))
+      {
+        for (j = 0; reader.NextItem(m, j) && reader.ReadText(name); j++)
+        {
+          if (name == GetBlockStartKey()) reader.ReadUnsigned(t);
+          else if (!parameters.SetFromCBOR(name, reader)) reader.Skip();
+        }
+      }
+      starts.push_back(t);
+
+      // next block follows on from this one unless it says otherwise
+      t += parameters.GetDuration();
+    }
+  }
+
+  if (reader.IsValid())
+  {
+    Clear();
+    for (i = 0; i < decoded.size(); i++) Add(starts[i], decoded[i]);
+  }
+  else BBCERROR("CBOR timeline for channel %u is truncated or invalid", GetChannel());
+
+  return reader.IsValid() ? (uint_t)reader.GetPosition() : 0;
+}
+
+#if ENABLE_JSON
+/*--------------------------------------------------------------------------------*/
+/** Replace blocks with those in a JSON object as generated by ToJSON()
+ *
+ * @return true if the object contained a parameters array
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineCursor::FromJSON(const json_spirit::mObject& obj)
+{
+  json_spirit::mObject::const_iterator it;
+  bool success = false;
+
+  if (((it = obj.find("parameters")) != obj.end()) && (it->second.type() == json_spirit::array_type))
+  {
+    FromJSONArray(it->second.get_array());
+    success = true;
+  }
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Replace blocks with those in a JSON array as generated by ToJSONArray()
+ *
+ * @note blocks without a start time are placed directly after the previous block
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineCursor::FromJSONArray(const json_spirit::mArray& array)
+{
+  uint64_t t = 0;
+  uint_t i;
+
+  Clear();
+
+  for (i = 0; i < array.size(); i++)
+  {
+    if (array[i].type() == json_spirit::obj_type)
+    {
+      const json_spirit::mObject& obj = array[i].get_obj();
+      json_spirit::mObject::const_iterator it;
+      AudioObjectParameters parameters(obj);
+      sint64_t start;
+
+      if (((it = obj.find(GetBlockStartKey())) != obj.end()) && bbcat::FromJSON(it->second, start)) t = (uint64_t)start;
+
+      Add(t, parameters);
+
+      // next block follows on from this one unless it says otherwise
+      t += parameters.GetDuration();
+    }
+    else BBCERROR("Block %u of timeline is not an object", i);
+  }
+}
+#endif
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,230 @@
+#ifndef __AUDIO_OBJECT_TIMELINE_CURSOR__
+#define __AUDIO_OBJECT_TIMELINE_CURSOR__
+
+#include <deque>
+
+#include "AudioObjectBlockCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** A cursor holding a timeline of blocks of parameters in memory
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectTimelineCursor : public AudioObjectBlockCursor
+{
+public:
+  AudioObjectTimelineCursor(uint_t _channel = 0, AudioObject *_object = NULL) : AudioObjectBlockCursor(_channel, _object),
+                                                                               mergetolerance(0.0),
+                                                                               mergeblocks(false) {}
+  virtual ~AudioObjectTimelineCursor() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add a block of parameters starting at time t (ns)
+   *
+   * @note if a block already starts at t, it is replaced
+   * @note adding blocks in time order is the most efficient
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void Add(uint64_t t, const AudioObjectParameters& parameters);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove all blocks
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void Clear();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return parameters of block n or NULL if n is out of range
+   *
+   * @note the returned object remains valid until blocks are inserted before it or removed
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual const AudioObjectParameters *GetBlockParameters(uint_t n) const {return (n < blocks.size()) ? &blocks[n] : NULL;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether GetBlockParameters() may be called from several threads at once
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool IsReadThreadSafe() const {return true;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Record audio object parameters at the current time (i.e. the time of the last Seek())
+   *
+   * The previous block is ended at the current time and a new block started unless block
+   * merging is enabled and the parameters match those of the previous block, in which case
+   * the previous block is extended instead
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void SetObjectParameters(const AudioObjectParameters& newparameters);
+
+  /*--------------------------------------------------------------------------------*/
+  /** End recording by ending the last block at the current time
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void EndChanges();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Enable/disable merging of recorded blocks that match the previous block
+   *
+   * @param enable true to merge matching blocks
+   * @param tolerance maximum absolute difference of numeric values for blocks to match (0 = exact match)
+   *
+   * @note the tolerance is applied to each value in its own units (e.g. degrees for polar azimuth
+   * and elevation, metres for polar distance, a linear factor for gain), see AudioObjectParameters::Matches()
+   * @note interpolation times must match exactly
+   * @note recorded parameters are always compared with those at the start of the previous block
+   * so merging with a tolerance cannot drift further than the tolerance
+   * @note durations are ignored when comparing blocks
+   */
+  /*--------------------------------------------------------------------------------*/
+  void   EnableBlockMerging(bool enable = true, double tolerance = 0.0) {mergeblocks = enable; mergetolerance = tolerance;}
+  bool   IsBlockMergingEnabled() const {return mergeblocks;}
+  double GetMergeTolerance() const {return mergetolerance;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Tolerances for Thin()
+   */
+  /*--------------------------------------------------------------------------------*/
+  enum {
+    MaxThinningSpan = 64,   // maximum number of original blocks covered by each block remaining after Thin()
+  };
+
+  typedef struct {
+    double angle;         // maximum error of polar azimuth and elevation (degrees)
+    double distance;      // maximum error of polar distance or cartesian position (metres)
+    double gain;          // maximum error of gain (dB)
+  } THINNINGTOLERANCES;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove blocks whose removal changes the rendered position and gain by no more than tolerances
+   *
+   * @param tolerances maximum errors allowed
+   *
+   * @return number of blocks removed
+   *
+   * @note the timeline is rendered as AudioObjectBlockPipeline does: each block interpolates from the
+   * previous block's parameters to its own, starting at its start and lasting its interpolation time
+   * (limited by the start of the next block), and then holds its own parameters
+   * @note interpolation times are never changed so removal is only possible where the rendering of
+   * the remaining blocks (holds, or interpolations extended by the later start of the next block)
+   * follows that of the original blocks within tolerances
+   * @note blocks are only removed if all other parameters match the previous remaining block exactly
+   * @note durations (where set) of remaining blocks are extended to cover removed blocks
+   * @note each remaining block covers at most MaxThinningSpan original blocks, which bounds the cost to O(n * MaxThinningSpan)
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Thin(const THINNINGTOLERANCES& tolerances);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Replace blocks with those in a CBOR array as generated by ToCBOR()
+   *
+   * @param data CBOR data
+   * @param size maximum number of bytes available
+   *
+   * @return number of bytes used or 0 if the data is invalid or truncated
+   *
+   * @note blocks without a start time are placed directly after the previous block (as FromJSONArray())
+   * @note on failure, the blocks are left unchanged
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint_t FromCBOR(const uint8_t *data, uint64_t size);
+
+#if ENABLE_JSON
+  /*--------------------------------------------------------------------------------*/
+  /** Replace blocks with those in a JSON object as generated by ToJSON()
+   *
+   * @return true if the object contained a parameters array
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool FromJSON(const json_spirit::mObject& obj);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Replace blocks with those in a JSON array as generated by ToJSONArray()
+   *
+   * @note blocks without a start time are placed directly after the previous block
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void FromJSONArray(const json_spirit::mArray& array);
+#endif
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** End last block at time t (ns)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void EndLastBlock(uint64_t t);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Update end time after the end of block n has changed from oldend
+   *
+   * @note the end time is only recalculated from all blocks if block n has been shortened
+   */
+  /*--------------------------------------------------------------------------------*/
+  void UpdateBlockEnd(uint_t n, uint64_t oldend);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Part of the rendering of a timeline: block n interpolating from block previous between start and rampend then holding until end
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef struct {
+    uint_t   previous;
+    uint_t   n;
+    uint64_t start;
+    uint64_t rampend;
+    uint64_t end;
+  } RENDERSEGMENT;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return rendering of block n from block previous (previous == n for the first block) ending at end
+   */
+  /*--------------------------------------------------------------------------------*/
+  RENDERSEGMENT GetRenderSegment(uint_t previous, uint_t n, uint64_t end) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return end of rendering of block n in the original timeline
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetRenderEnd(uint_t n) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether blocks between blocks a and c can be removed, given that block p is the block before a after thinning
+   *
+   * @param first first block whose original rendering needs to be checked (blocks before it have already been checked and are unaffected)
+   * @param keys position and gain only of each block
+   * @param rendered1, rendered2 workspace
+   *
+   * @note compares the original rendering with that of the thinned timeline from the start of first up to the end of c's first block
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool CanRemove(uint_t p, uint_t a, uint_t c, uint_t first, const std::vector<AudioObjectParameters>& keys, AudioObjectParameters& rendered1, AudioObjectParameters& rendered2, const THINNINGTOLERANCES& tolerances) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether the renderings of segments 1 and 2 are within tolerances where they overlap
+   *
+   * @note both renderings are linear between interpolation start and end points so only those points need checking
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool IsRenderedWithin(const RENDERSEGMENT& segment1, const RENDERSEGMENT& segment2, const std::vector<AudioObjectParameters>& keys, AudioObjectParameters& rendered1, AudioObjectParameters& rendered2, const THINNINGTOLERANCES& tolerances);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Render segment at time t (start <= t <= end) using keys
+   */
+  /*--------------------------------------------------------------------------------*/
+  static void Render(const RENDERSEGMENT& segment, uint64_t t, const std::vector<AudioObjectParameters>& keys, AudioObjectParameters& parameters);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether the positions and gains of parameters1 and parameters2 are within tolerances
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool IsWithinTolerances(const AudioObjectParameters& parameters1, const AudioObjectParameters& parameters2, const THINNINGTOLERANCES& tolerances);
+
+protected:
+  std::deque<AudioObjectParameters> blocks;
+  double                            mergetolerance;
+  bool                              mergeblocks;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -0,0 +1,406 @@
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectTimelineFile.h"
+#include "AudioObjectBinary.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Offsets of fields within the header, channel table entries and block index entries
+ */
+/*--------------------------------------------------------------------------------*/
+enum {
+  Header_magic        = 0,
+  Header_version      = 8,
+  Header_channelcount = 12,
+  Header_channeltable = 16,
+  Header_filesize     = 24,
+  Header_sourcesize   = 32,
+  Header_sourcemtime  = 40,
+  Header_sourcehash   = 48,
+  // remainder of header reserved (zero)
+
+  Channel_channel     = 0,
+  Channel_blockcount  = 4,
+  Channel_indexoffset = 8,
+  Channel_endtime     = 16,
+
+  Index_start         = 0,
+  Index_recordoffset  = 8,
+};
+
+AudioObjectTimelineFile::AudioObjectTimelineFile() : data(NULL),
+                                                     size(0),
+                                                     channeltable(0),
+                                                     channelcount(0)
+#ifdef _WIN32
+                                                     , mapping(NULL)
+#endif
+{
+}
+
+AudioObjectTimelineFile::~AudioObjectTimelineFile()
+{
+  Close();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write timelines of cursors to file
+ *
+ * @return true if file written successfully
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineFile::Write(const std::string& filename, const std::vector<const AudioObjectBlockCursor *>& cursors, const SOURCEKEY *key)
+{
+  FILE *fp;
+  bool success = false;
+
+  if ((fp = fopen(filename.c_str(), "wb")) != NULL)
+  {
+    std::vector<std::vector<uint8_t> > indexes;
+    std::vector<uint8_t> header(HeaderSize, 0), table, record;
+    AudioObjectBinaryWriter tablewriter(table);
+    uint64_t offset = HeaderSize;
+    uint_t   i, j, nchannels = 0;
+
+    success = (fwrite(&header[0], header.size(), 1, fp) == 1);
+
+    // write block records of each channel, building each channel's index as we go
+    for (i = 0; success && (i < cursors.size()); i++)
+    {
+      const AudioObjectBlockCursor *cursor = cursors[i];
+
+      if (!cursor) continue;
+
+      indexes.push_back(std::vector<uint8_t>());
+
+      AudioObjectBinaryWriter indexwriter(indexes.back());
+      uint_t nblocks = cursor->GetBlockCount();
+
+      for (j = 0; success && (j < nblocks); j++)
+      {
+        const AudioObjectParameters *parameters;
+
+        record.clear();
+        if ((parameters = cursor->GetBlockParameters(j)) != NULL) parameters->ToBinary(record);
+        else AudioObjectParameters().ToBinary(record);
+
+        indexwriter.Write(cursor->GetBlockStart(j));
+        indexwriter.Write(offset);
+
+        success = (fwrite(&record[0], record.size(), 1, fp) == 1);
+        offset += record.size();
+      }
+    }
+
+    // write indexes and channel table
+    for (i = 0; success && (i < cursors.size()); i++)
+    {
+      const AudioObjectBlockCursor *cursor = cursors[i];
+
+      if (!cursor) continue;
+
+      const std::vector<uint8_t>& index = indexes[nchannels++];
+
+      tablewriter.Write((uint32_t)cursor->GetChannel());
+      tablewriter.Write((uint32_t)cursor->GetBlockCount());
+      tablewriter.Write(offset);
+      tablewriter.Write(cursor->GetEndTime());
+
+      if (index.size()) success = (fwrite(&index[0], index.size(), 1, fp) == 1);
+      offset += index.size();
+    }
+
+    if (success && table.size()) success = (fwrite(&table[0], table.size(), 1, fp) == 1);
+
+    // finally, fill in and re-write header
+    if (success)
+    {
+      memcpy(&header[Header_magic], GetMagic(), 8);
+      AudioObjectBinaryWriter::Encode(&header[Header_version],      Version, 4);
+      AudioObjectBinaryWriter::Encode(&header[Header_channelcount], nchannels, 4);
+      AudioObjectBinaryWriter::Encode(&header[Header_channeltable], offset, 8);
+      AudioObjectBinaryWriter::Encode(&header[Header_filesize],     offset + table.size(), 8);
+      if (key)
+      {
+        AudioObjectBinaryWriter::Encode(&header[Header_sourcesize],  key->size, 8);
+        AudioObjectBinaryWriter::Encode(&header[Header_sourcemtime], key->mtime, 8);
+        AudioObjectBinaryWriter::Encode(&header[Header_sourcehash],  key->hash, 8);
+      }
+
+      success = ((fseek(fp, 0, SEEK_SET) == 0) && (fwrite(&header[0], header.size(), 1, fp) == 1));
+    }
+
+    if (fclose(fp) != 0) success = false;
+
+    if (success) BBCDEBUG3(("Written %u channels to timeline file '%s'", nchannels, filename.c_str()));
+    else         BBCERROR("Failed to write timeline file '%s'", filename.c_str());
+  }
+  else BBCERROR("Failed to open timeline file '%s' for writing", filename.c_str());
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Map and validate file
+ *
+ * @return true if file is a valid timeline file
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineFile::Open(const std::string& filename)
+{
+  uint_t i;
+  bool   valid;
+
+  Close();
+
+#ifdef _WIN32
+  HANDLE        handle;
+  LARGE_INTEGER filesize;
+
+  if ((handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL)) != INVALID_HANDLE_VALUE)
+  {
+    if (GetFileSizeEx(handle, &filesize) && (filesize.QuadPart >= HeaderSize) &&
+        ((mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL)) != NULL))
+    {
+      if ((data = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) != NULL) size = filesize.QuadPart;
+      else
+      {
+        CloseHandle(mapping);
+        mapping = NULL;
+      }
+    }
+
+    CloseHandle(handle);
+  }
+#else
+  struct stat st;
+  int fd;
+
+  if ((fd = open(filename.c_str(), O_RDONLY)) >= 0)
+  {
+    if ((fstat(fd, &st) == 0) && (st.st_size >= HeaderSize))
+    {
+      void *p;
+
+      // the mapping remains valid after the file is closed
+      if ((p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0)) != MAP_FAILED)
+      {
+        data = (const uint8_t *)p;
+        size = st.st_size;
+      }
+    }
+
+    close(fd);
+  }
+#endif
+
+  if (!data)
+  {
+    BBCERROR("Failed to map timeline file '%s'", filename.c_str());
+    return false;
+  }
+
+  // validate header
+  channelcount = (uint_t)AudioObjectBinaryReader::Decode(data + Header_channelcount, 4);
+  channeltable = AudioObjectBinaryReader::Decode(data + Header_channeltable, 8);
+
+  valid = ((memcmp(data + Header_magic, GetMagic(), 8) == 0) &&
+           (AudioObjectBinaryReader::Decode(data + Header_version, 4) == Version) &&
+           (AudioObjectBinaryReader::Decode(data + Header_filesize, 8) == size) &&
+           (channeltable <= size) &&
+           ((uint64_t)channelcount <= ((size - channeltable) / ChannelEntrySize)));
+
+  // validate channel table (block indexes are validated when cursors are created)
+  for (i = 0; valid && (i < channelcount); i++)
+  {
+    const uint8_t *entry = GetChannelEntry(i);
+    uint64_t indexoffset = AudioObjectBinaryReader::Decode(entry + Channel_indexoffset, 8);
+    uint64_t nblocks     = AudioObjectBinaryReader::Decode(entry + Channel_blockcount, 4);
+
+    valid = ((indexoffset <= size) && (nblocks <= ((size - indexoffset) / IndexEntrySize)));
+  }
+
+  if (valid) BBCDEBUG3(("Opened timeline file '%s' (%u channels)", filename.c_str(), channelcount));
+  else
+  {
+    BBCERROR("Timeline file '%s' is invalid", filename.c_str());
+    Close();
+  }
+
+  return valid;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Unmap file
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineFile::Close()
+{
+  if (data)
+  {
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    mapping = NULL;
+#else
+    munmap((void *)data, size);
+#endif
+    data = NULL;
+  }
+
+  size         = 0;
+  channeltable = 0;
+  channelcount = 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return channel number of nth channel in file
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectTimelineFile::GetChannel(uint_t n) const
+{
+  return (n < channelcount) ? (uint_t)AudioObjectBinaryReader::Decode(GetChannelEntry(n) + Channel_channel, 4) : 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return block count of nth channel in file
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectTimelineFile::GetBlockCount(uint_t n) const
+{
+  return (n < channelcount) ? (uint_t)AudioObjectBinaryReader::Decode(GetChannelEntry(n) + Channel_blockcount, 4) : 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return key of source stored in header
+ *
+ * @return false if file is not open or no key was stored
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineFile::GetSourceKey(SOURCEKEY& key) const
+{
+  bool valid = false;
+
+  if (data)
+  {
+    key.size  = AudioObjectBinaryReader::Decode(data + Header_sourcesize, 8);
+    key.mtime = AudioObjectBinaryReader::Decode(data + Header_sourcemtime, 8);
+    key.hash  = AudioObjectBinaryReader::Decode(data + Header_sourcehash, 8);
+
+    // a file written without a key has all zero key fields
+    valid = (key.size || key.mtime || key.hash);
+  }
+
+  return valid;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Create cursor for nth channel in file
+ *
+ * @return new cursor (owned by caller) or NULL if n is out of range or the block index is invalid
+ */
+/*--------------------------------------------------------------------------------*/
+AudioObjectTimelineFileCursor *AudioObjectTimelineFile::CreateCursor(uint_t n, AudioObject *object) const
+{
+  AudioObjectTimelineFileCursor *cursor = NULL;
+
+  if (n < channelcount)
+  {
+    cursor = new AudioObjectTimelineFileCursor(*this, GetChannel(n), object);
+
+    if (!cursor->ReadIndex(n))
+    {
+      BBCERROR("Block index of channel %u of timeline file is invalid", cursor->GetChannel());
+      delete cursor;
+      cursor = NULL;
+    }
+  }
+
+  return cursor;
+}
+
+AudioObjectTimelineFileCursor::AudioObjectTimelineFileCursor(const AudioObjectTimelineFile& _file, uint_t _channel, AudioObject *_object) : AudioObjectDecodingCursor(_channel, _object),
+                                                                                                                                            file(_file),
+                                                                                                                                            indexoffset(0),
+                                                                                                                                            nblocks(0)
+{
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set up access to block index of nth channel of file
+ *
+ * @return true if index is valid
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineFileCursor::ReadIndex(uint_t n)
+{
+  const uint8_t *entry = file.GetChannelEntry(n);
+  bool valid;
+
+  nblocks     = (uint_t)AudioObjectBinaryReader::Decode(entry + Channel_blockcount, 4);
+  indexoffset = AudioObjectBinaryReader::Decode(entry + Channel_indexoffset, 8);
+  endtime     = AudioObjectBinaryReader::Decode(entry + Channel_endtime, 8);
+
+  // nothing is copied, the index is read from the file when required
+  // (its bounds are checked by Open() and record offsets by DecodeBlock())
+  valid = ((indexoffset + (uint64_t)nblocks * AudioObjectTimelineFile::IndexEntrySize) <= file.size);
+  if (!valid) nblocks = 0;
+
+  return valid;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return start time of block n in ns (the end time if n is the block count or beyond)
+ */
+/*--------------------------------------------------------------------------------*/
+uint64_t AudioObjectTimelineFileCursor::GetBlockStart(uint_t n) const
+{
+  return (n < nblocks) ? AudioObjectBinaryReader::Decode(GetIndexEntry(n) + Index_start, 8) : endtime;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return index of block that is current at time t (ns) without moving the cursor
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectTimelineFileCursor::FindBlock(uint64_t t) const
+{
+  uint_t lo = 0, hi = nblocks;
+
+  // find first block starting after t
+  while (lo < hi)
+  {
+    uint_t mid = (lo + hi) / 2;
+    if (AudioObjectBinaryReader::Decode(GetIndexEntry(mid) + Index_start, 8) <= t) lo = mid + 1;
+    else                                                                             hi = mid;
+  }
+
+  // the block before that is the current one (if t is before the first block, use the first block)
+  return lo ? lo - 1 : 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Decode block record n
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectTimelineFileCursor::DecodeBlock(uint_t n, AudioObjectParameters& parameters) const
+{
+  uint64_t offset = AudioObjectBinaryReader::Decode(GetIndexEntry(n) + Index_recordoffset, 8);
+
+  // records must be within the file
+  return ((offset < file.size) && (parameters.FromBinary(file.data + offset, file.size - offset) != 0));
+}
+
+BBC_AUDIOTOOLBOX_END
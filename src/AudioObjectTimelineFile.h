@@ -0,0 +1,223 @@
+#ifndef __AUDIO_OBJECT_TIMELINE_FILE__
+#define __AUDIO_OBJECT_TIMELINE_FILE__
+
+#include <string>
+#include <vector>
+
+#include "AudioObjectDecodingCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+class AudioObjectTimelineFileCursor;
+
+/*--------------------------------------------------------------------------------*/
+/** A memory-mapped binary file of timelines of audio object parameters (one per channel)
+ *
+ * The file consists of (all values little-endian):
+ * - a header: magic, version, channel count, offset of channel table, file size and (optionally)
+ *   the key of the source the file was generated from (see AudioObjectTimelineCache)
+ * - block records: each is an AudioObjectParameters::ToBinary() representation
+ * - per-channel block indexes: sorted entries of block start time (ns) and offset of block record
+ * - channel table: for each channel, channel number, block count, offset of block index and end time (ns)
+ *
+ * Opening a file only maps and validates it, nothing is decoded: cursors created by CreateCursor()
+ * search their channel's block index in place and decode block records only when they are used,
+ * so the index and block data are held by the page cache rather than on the heap and creating a
+ * cursor takes constant time regardless of the number of blocks
+ *
+ * @note the file MUST outlive all cursors created from it
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectTimelineFile
+{
+public:
+  AudioObjectTimelineFile();
+  ~AudioObjectTimelineFile();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Sizes of the fixed parts of the file
+   */
+  /*--------------------------------------------------------------------------------*/
+  enum {
+    Version          = 1,
+    HeaderSize       = 64,
+    ChannelEntrySize = 24,
+    IndexEntrySize   = 16,
+  };
+
+  /*--------------------------------------------------------------------------------*/
+  /** Key identifying the source (e.g. a JSON file) a timeline file was generated from
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef struct {
+    uint64_t size;        // size of source in bytes
+    uint64_t mtime;       // modification time of source (s since epoch)
+    uint64_t hash;        // hash of source contents
+  } SOURCEKEY;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write timelines of cursors to file
+   *
+   * @param filename file to write
+   * @param cursors list of cursors, one per channel (NULL entries are ignored)
+   * @param key optional key of source of timelines to store in header
+   *
+   * @return true if file written successfully
+   *
+   * @note the cursors are NOT moved
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool Write(const std::string& filename, const std::vector<const AudioObjectBlockCursor *>& cursors, const SOURCEKEY *key = NULL);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Map and validate file
+   *
+   * @return true if file is a valid timeline file
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Open(const std::string& filename);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Unmap file
+   *
+   * @note all cursors created from this file MUST have been deleted
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Close();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether file is open
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsOpen() const {return (data != NULL);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of channels in file
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetChannelCount() const {return channelcount;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return channel number or block count of nth channel in file
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetChannel(uint_t n) const;
+  uint_t GetBlockCount(uint_t n) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return key of source stored in header
+   *
+   * @return false if file is not open or no key was stored
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool GetSourceKey(SOURCEKEY& key) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Create cursor for nth channel in file
+   *
+   * @return new cursor (owned by caller) or NULL if n is out of range or the block index is invalid
+   */
+  /*--------------------------------------------------------------------------------*/
+  AudioObjectTimelineFileCursor *CreateCursor(uint_t n, AudioObject *object = NULL) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return magic identifier at the start of the file
+   */
+  /*--------------------------------------------------------------------------------*/
+  static const char *GetMagic() {return "BBCATL01";}
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Return pointer to nth entry of channel table
+   */
+  /*--------------------------------------------------------------------------------*/
+  const uint8_t *GetChannelEntry(uint_t n) const {return data + channeltable + (uint64_t)n * ChannelEntrySize;}
+
+  friend class AudioObjectTimelineFileCursor;
+
+protected:
+  const uint8_t *data;
+  uint64_t      size;
+  uint64_t      channeltable;
+  uint_t        channelcount;
+#ifdef _WIN32
+  void          *mapping;
+#endif
+
+private:
+  // prevent copying
+  AudioObjectTimelineFile(const AudioObjectTimelineFile& obj);
+  AudioObjectTimelineFile& operator = (const AudioObjectTimelineFile& obj);
+};
+
+/*--------------------------------------------------------------------------------*/
+/** A cursor reading one channel of an AudioObjectTimelineFile
+ *
+ * Block records are decoded on demand (see AudioObjectDecodingCursor) and the block index is
+ * read directly from the file
+ *
+ * @note the index is not checked for order (which would take time proportional to its length)
+ * so a corrupt index may give the wrong blocks but never reads outside the file
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectTimelineFileCursor : public AudioObjectDecodingCursor
+{
+public:
+  virtual ~AudioObjectTimelineFileCursor() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of blocks
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint_t GetBlockCount() const {return nblocks;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return start time of block n in ns (the end time if n is the block count or beyond)
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint64_t GetBlockStart(uint_t n) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return index of block that is current at time t (ns) without moving the cursor
+   *
+   * @note binary searches the index in the file
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual uint_t FindBlock(uint64_t t) const;
+
+protected:
+  friend class AudioObjectTimelineFile;
+
+  AudioObjectTimelineFileCursor(const AudioObjectTimelineFile& _file, uint_t _channel, AudioObject *_object);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set up access to block index of nth channel of file
+   *
+   * @return true if index is valid
+   *
+   * @note the index's position and size have already been validated by AudioObjectTimelineFile::Open()
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadIndex(uint_t n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return pointer to entry n of block index
+   */
+  /*--------------------------------------------------------------------------------*/
+  const uint8_t *GetIndexEntry(uint_t n) const {return file.data + indexoffset + (uint64_t)n * AudioObjectTimelineFile::IndexEntrySize;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Decode block record n
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool DecodeBlock(uint_t n, AudioObjectParameters& parameters) const;
+
+protected:
+  const AudioObjectTimelineFile& file;
+  uint64_t                       indexoffset;   // offset of block index in file
+  uint_t                         nblocks;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
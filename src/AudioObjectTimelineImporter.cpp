@@ -0,0 +1,197 @@
+
+#include <algorithm>
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectTimelineImporter.h"
+#include "AudioObjectTimelineCache.h"
+
+BBC_AUDIOTOOLBOX_START
+
+#if ENABLE_JSON
+/*--------------------------------------------------------------------------------*/
+/** Add JSON file to be imported into cursor (NOT owned)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineImporter::AddFile(const std::string& filename, AudioObjectTimelineCursor *cursor)
+{
+  Add(filename, "", cursor);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add JSON text to be imported into cursor (NOT owned)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineImporter::AddText(const std::string& text, AudioObjectTimelineCursor *cursor)
+{
+  Add("", text, cursor);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add source
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineImporter::Add(const std::string& filename, const std::string& text, AudioObjectTimelineCursor *cursor)
+{
+  INPUT *input = new INPUT;
+
+  input->filename = filename;
+  input->text     = text;
+  input->cursor   = cursor;
+  input->scanner  = NULL;
+  input->success  = false;
+
+  inputs.push_back(input);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove all sources
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineImporter::Clear()
+{
+  uint_t i;
+
+  for (i = 0; i < inputs.size(); i++)
+  {
+    delete inputs[i]->scanner;
+    delete inputs[i];
+  }
+
+  inputs.clear();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Import all sources into their cursors
+ *
+ * @param pool optional pool of threads to import on (NULL to import on the calling thread)
+ * @param chunksize number of blocks parsed by each task
+ *
+ * @return number of sources imported successfully
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectTimelineImporter::Import(TaskPool *pool, uint_t chunksize)
+{
+  typedef struct {
+    uint_t input;
+    uint_t start;
+    uint_t end;
+  } CHUNK;
+  std::vector<CHUNK> chunks;
+  uint_t i, j, n = 0;
+
+  if (!chunksize) chunksize = DefaultChunkSize;
+
+  Run(pool, (uint_t)inputs.size(), [this](uint_t k) {Scan(k);});
+
+  // split blocks of all sources into chunks
+  for (i = 0; i < inputs.size(); i++)
+  {
+    uint_t nblocks = (uint_t)inputs[i]->blocks.size();
+
+    for (j = 0; inputs[i]->success && (j < nblocks); j += chunksize)
+    {
+      CHUNK chunk;
+
+      chunk.input = i;
+      chunk.start = j;
+      chunk.end   = std::min(j + chunksize, nblocks);
+      chunks.push_back(chunk);
+    }
+  }
+
+  Run(pool, (uint_t)chunks.size(), [this, &chunks](uint_t k) {Parse(chunks[k].input, chunks[k].start, chunks[k].end);});
+
+  Run(pool, (uint_t)inputs.size(), [this](uint_t k) {Build(k);});
+
+  for (i = 0; i < inputs.size(); i++)
+  {
+    if (inputs[i]->success) n++;
+  }
+
+  BBCDEBUG3(("Imported %u/%u timelines (%u chunks)", n, (uint_t)inputs.size(), (uint_t)chunks.size()));
+
+  return n;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Phase 1: read and scan source n
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineImporter::Scan(uint_t n)
+{
+  INPUT& input = *inputs[n];
+  bool   success = true;
+
+  if (!input.filename.empty() && !(success = AudioObjectTimelineCache::ReadFile(input.filename, input.text)))
+  {
+    BBCERROR("Failed to read timeline file '%s'", input.filename.c_str());
+  }
+
+  delete input.scanner;
+  input.scanner = new AudioObjectLazyJSONCursor(input.cursor->GetChannel(), input.cursor->GetAudioObject());
+
+  if (success && (success = input.scanner->SetText(input.text)))
+  {
+    input.blocks.resize(input.scanner->GetBlockCount());
+  }
+
+  // the scanner keeps its own copy of the text so the contents of files can be released
+  if (!input.filename.empty()) std::string().swap(input.text);
+
+  input.success = success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Phase 2: parse blocks [start, end) of source n
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineImporter::Parse(uint_t n, uint_t start, uint_t end)
+{
+  INPUT& input = *inputs[n];
+  uint_t i;
+
+  for (i = start; (i < end) && input.success; i++)
+  {
+    if (!input.scanner->ParseBlock(i, input.blocks[i])) input.success = false;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Phase 3: replace blocks of cursor of source n
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineImporter::Build(uint_t n)
+{
+  INPUT& input = *inputs[n];
+  uint_t i;
+
+  if (input.success)
+  {
+    input.cursor->Clear();
+
+    // blocks are in time order so each is appended
+    for (i = 0; i < input.blocks.size(); i++) input.cursor->Add(input.scanner->GetBlockStart(i), input.blocks[i]);
+  }
+
+  std::vector<AudioObjectParameters>().swap(input.blocks);
+  delete input.scanner;
+  input.scanner = NULL;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Run count tasks on pool or, if pool is NULL, on the calling thread
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectTimelineImporter::Run(TaskPool *pool, uint_t count, const TaskPool::TASK& task)
+{
+  uint_t i;
+
+  if (pool) pool->Run(count, task);
+  else
+  {
+    for (i = 0; i < count; i++) task(i);
+  }
+}
+#endif
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,134 @@
+#ifndef __AUDIO_OBJECT_TIMELINE_IMPORTER__
+#define __AUDIO_OBJECT_TIMELINE_IMPORTER__
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "AudioObjectLazyJSONCursor.h"
+#include "AudioObjectTimelineCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+#if ENABLE_JSON
+/*--------------------------------------------------------------------------------*/
+/** Bulk importer of JSON timelines (e.g. one file per channel) into AudioObjectTimelineCursors using a pool of threads
+ *
+ * Import() runs in three parallel phases:
+ * 1. each source is read (if it is a file) and scanned for the text of its blocks (see AudioObjectLazyJSONCursor)
+ * 2. the blocks of all sources are split into chunks and parsed, so even a single large source
+ *    is parsed on all threads
+ * 3. each cursor's blocks are replaced with the parsed blocks
+ *
+ * The result is the same as using AudioObjectTimelineCursor::FromJSON() or FromJSONArray() on
+ * the parsed text of each source.
+ *
+ * @note each cursor MUST only be used for one source and MUST NOT be used by anything else during Import()
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectTimelineImporter
+{
+public:
+  AudioObjectTimelineImporter() {}
+  ~AudioObjectTimelineImporter() {Clear();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add JSON file to be imported into cursor (NOT owned)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void AddFile(const std::string& filename, AudioObjectTimelineCursor *cursor);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add JSON text to be imported into cursor (NOT owned)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void AddText(const std::string& text, AudioObjectTimelineCursor *cursor);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove all sources
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Clear();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of sources
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetCount() const {return (uint_t)inputs.size();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Import all sources into their cursors
+   *
+   * @param pool optional pool of threads to import on (NULL to import on the calling thread)
+   * @param chunksize number of blocks parsed by each task
+   *
+   * @return number of sources imported successfully
+   *
+   * @note the cursors of sources that fail to import are left unchanged
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Import(TaskPool *pool = NULL, uint_t chunksize = DefaultChunkSize);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether source n was imported successfully by the last Import()
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsImported(uint_t n) const {return (n < inputs.size()) && inputs[n]->success;}
+
+  enum {
+    DefaultChunkSize = 64,
+  };
+
+protected:
+  typedef struct {
+    std::string                        filename;    // empty if text was supplied
+    std::string                        text;
+    AudioObjectTimelineCursor          *cursor;
+    AudioObjectLazyJSONCursor          *scanner;
+    std::vector<AudioObjectParameters> blocks;
+    std::atomic<bool>                  success;
+  } INPUT;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add source
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Add(const std::string& filename, const std::string& text, AudioObjectTimelineCursor *cursor);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Phase 1: read and scan source n
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Scan(uint_t n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Phase 2: parse blocks [start, end) of source n
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Parse(uint_t n, uint_t start, uint_t end);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Phase 3: replace blocks of cursor of source n
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Build(uint_t n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Run count tasks on pool or, if pool is NULL, on the calling thread
+   */
+  /*--------------------------------------------------------------------------------*/
+  static void Run(TaskPool *pool, uint_t count, const TaskPool::TASK& task);
+
+protected:
+  std::vector<INPUT *> inputs;
+
+private:
+  // prevent copying
+  AudioObjectTimelineImporter(const AudioObjectTimelineImporter& obj);
+  AudioObjectTimelineImporter& operator = (const AudioObjectTimelineImporter& obj);
+};
+#endif
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
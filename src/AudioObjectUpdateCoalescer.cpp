@@ -0,0 +1,200 @@
+
+#define BBCDEBUG_LEVEL 1
+#include "AudioObjectUpdateCoalescer.h"
+
+BBC_AUDIOTOOLBOX_START
+
+AudioObjectUpdateCoalescer::AudioObjectUpdateCoalescer(uint64_t _blockperiod, FLUSHPOLICY _policy) : blockperiod(_blockperiod),
+                                                                                                     updatecount(0),
+                                                                                                     outputcount(0),
+                                                                                                     policy(_policy),
+                                                                                                     maxupdates(0)
+{
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set number of channels
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectUpdateCoalescer::SetChannelCount(uint_t n)
+{
+  uint_t i, j;
+
+  // remove pending entries of channels being removed
+  for (i = j = 0; i < pendingchannels.size(); i++)
+  {
+    if (pendingchannels[i] < n) pendingchannels[j++] = pendingchannels[i];
+  }
+  pendingchannels.resize(j);
+
+  CHANNEL channel;
+  channel.cursor    = NULL;
+  channel.firsttime = 0;
+  channel.updates   = 0;
+  channel.listed    = false;
+  channels.resize(n, channel);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set cursor to receive flushed parameters for channel (the cursor is NOT owned)
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectUpdateCoalescer::SetCursor(uint_t channel, AudioObjectCursor *cursor)
+{
+  if (channel >= channels.size()) SetChannelCount(channel + 1);
+  channels[channel].cursor = cursor;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set accumulated state of channel
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectUpdateCoalescer::SetState(uint_t channel, const AudioObjectParameters& parameters)
+{
+  if (channel >= channels.size()) SetChannelCount(channel + 1);
+  channels[channel].state = parameters;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add update for channel
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectUpdateCoalescer::Update(uint_t channel, uint64_t t, const AudioObjectParameters& parameters)
+{
+  if (channel >= channels.size()) SetChannelCount(channel + 1);
+
+  CHANNEL& chan = channels[channel];
+
+  if (!chan.updates) chan.firsttime = t;
+  if (!chan.listed)
+  {
+    pendingchannels.push_back(channel);
+    chan.listed = true;
+  }
+
+  chan.pending.Merge(parameters);
+  chan.updates++;
+  updatecount++;
+
+  if (maxupdates && (chan.updates >= maxupdates)) FlushChannel(channel, t);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return whether channel is due to be flushed at time t according to the flush policy
+ */
+/*--------------------------------------------------------------------------------*/
+bool AudioObjectUpdateCoalescer::IsDue(const CHANNEL& channel, uint64_t t) const
+{
+  bool due = false;
+
+  if (channel.updates)
+  {
+    switch (policy)
+    {
+      case Flush_Block:
+        // due at the end of the block in which the first update arrived
+        due = !blockperiod || (t >= (((channel.firsttime / blockperiod) + 1) * blockperiod));
+        break;
+
+      case Flush_Delay:
+        due = (t >= (channel.firsttime + blockperiod));
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  return due;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Flush channel if it has pending updates
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectUpdateCoalescer::FlushChannel(uint_t channel, uint64_t t)
+{
+  CHANNEL& chan = channels[channel];
+
+  if (chan.updates)
+  {
+    BBCDEBUG3(("Flushing %u updates for channel %u", chan.updates, channel));
+
+    chan.state.Merge(chan.pending);
+    // reset but keep allocations for re-use
+    chan.pending.ResetToDefaults();
+    chan.updates = 0;
+
+    Output(channel, t, chan.state);
+    outputcount++;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Flush any channels that are due to be flushed at time t (ns) according to the flush policy
+ *
+ * @return number of channels flushed
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectUpdateCoalescer::Process(uint64_t t)
+{
+  uint_t i, j, n = 0;
+
+  for (i = j = 0; i < pendingchannels.size(); i++)
+  {
+    uint_t channel = pendingchannels[i];
+
+    if (IsDue(channels[channel], t))
+    {
+      FlushChannel(channel, t);
+      n++;
+    }
+    // keep only channels that still have updates pending
+    if (channels[channel].updates) pendingchannels[j++] = channel;
+    else channels[channel].listed = false;
+  }
+  pendingchannels.resize(j);
+
+  return n;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Flush all channels with pending updates at time t (ns)
+ *
+ * @return number of channels flushed
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t AudioObjectUpdateCoalescer::Flush(uint64_t t)
+{
+  uint_t i, n = 0;
+
+  for (i = 0; i < pendingchannels.size(); i++)
+  {
+    uint_t channel = pendingchannels[i];
+
+    if (channels[channel].updates)
+    {
+      FlushChannel(channel, t);
+      n++;
+    }
+    channels[channel].listed = false;
+  }
+  pendingchannels.clear();
+
+  return n;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Output flushed parameters for channel
+ */
+/*--------------------------------------------------------------------------------*/
+void AudioObjectUpdateCoalescer::Output(uint_t channel, uint64_t t, const AudioObjectParameters& parameters)
+{
+  AudioObjectCursor *cursor = channels[channel].cursor;
+
+  UNUSED_PARAMETER(t);
+
+  if (cursor) cursor->SetObjectParameters(parameters);
+}
+
+BBC_AUDIOTOOLBOX_END
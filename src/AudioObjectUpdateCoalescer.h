@@ -0,0 +1,174 @@
+#ifndef __AUDIO_OBJECT_UPDATE_COALESCER__
+#define __AUDIO_OBJECT_UPDATE_COALESCER__
+
+#include <vector>
+
+#include "AudioObjectCursor.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Coalesces bursts of (partial) parameter updates per channel into a single update per block period
+ *
+ * Each update is Merge()d into a pending set of parameters for its channel, so only the
+ * parameters actually set in an update are changed.  When a channel's pending parameters are
+ * flushed (according to the flush policy), they are merged into the channel's accumulated state
+ * and the full state is output via Output() which, by default, passes it to the channel's cursor
+ * (if any) using SetObjectParameters().
+ *
+ * Only channels with pending updates are examined by Process() so the cost scales with the
+ * number of updating channels rather than the total number of channels.
+ *
+ * @note this class is NOT thread-safe, use an AudioObjectHandoffCursor as the output
+ * to pass updates to an audio thread
+ * @note cursors are NOT seeked by this class
+ */
+/*--------------------------------------------------------------------------------*/
+class AudioObjectUpdateCoalescer
+{
+public:
+  /*--------------------------------------------------------------------------------*/
+  /** Policies controlling when pending updates are flushed
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef enum {
+    Flush_Block = 0,      // flush at the end of the block period in which the first pending update arrived (block boundaries are multiples of the block period)
+    Flush_Delay,          // flush once the first pending update is one block period old
+    Flush_Manual,         // only flush when Flush() is called (or the update limit is reached)
+  } FLUSHPOLICY;
+
+  AudioObjectUpdateCoalescer(uint64_t _blockperiod = 0, FLUSHPOLICY _policy = Flush_Block);
+  virtual ~AudioObjectUpdateCoalescer() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set/Get block period (ns)
+   *
+   * @note a block period of 0 means updates are flushed by the next Process() call
+   */
+  /*--------------------------------------------------------------------------------*/
+  void     SetBlockPeriod(uint64_t period) {blockperiod = period;}
+  uint64_t GetBlockPeriod() const {return blockperiod;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set/Get flush policy
+   */
+  /*--------------------------------------------------------------------------------*/
+  void        SetFlushPolicy(FLUSHPOLICY _policy) {policy = _policy;}
+  FLUSHPOLICY GetFlushPolicy() const {return policy;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set/Get maximum number of updates coalesced before a channel is flushed regardless of policy (0 = no limit)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void   SetMaxUpdates(uint_t n) {maxupdates = n;}
+  uint_t GetMaxUpdates() const {return maxupdates;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set/Get number of channels
+   *
+   * @note channels are added automatically by Update()
+   */
+  /*--------------------------------------------------------------------------------*/
+  void   SetChannelCount(uint_t n);
+  uint_t GetChannelCount() const {return (uint_t)channels.size();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set cursor to receive flushed parameters for channel (the cursor is NOT owned)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void SetCursor(uint_t channel, AudioObjectCursor *cursor);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add update for channel
+   *
+   * @param channel channel number
+   * @param t time of update (ns)
+   * @param parameters parameters to update (only those set are updated)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Update(uint_t channel, uint64_t t, const AudioObjectParameters& parameters);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Flush any channels that are due to be flushed at time t (ns) according to the flush policy
+   *
+   * @return number of channels flushed
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Process(uint64_t t);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Flush all channels with pending updates at time t (ns)
+   *
+   * @return number of channels flushed
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Flush(uint64_t t);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether channel has pending updates
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsPending(uint_t channel) const {return (channel < channels.size()) && (channels[channel].updates != 0);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set/Get accumulated state of channel (all flushed updates merged together)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void                         SetState(uint_t channel, const AudioObjectParameters& parameters);
+  const AudioObjectParameters& GetState(uint_t channel) const {return (channel < channels.size()) ? channels[channel].state : emptyparameters;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return total number of updates received and number of outputs generated
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetUpdateCount() const {return updatecount;}
+  uint64_t GetOutputCount() const {return outputcount;}
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Output flushed parameters for channel
+   *
+   * @param channel channel number
+   * @param t time of flush (ns)
+   * @param parameters full accumulated state of channel
+   *
+   * @note by default, calls SetObjectParameters() of the channel's cursor (if it has one)
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void Output(uint_t channel, uint64_t t, const AudioObjectParameters& parameters);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Flush channel if it has pending updates
+   */
+  /*--------------------------------------------------------------------------------*/
+  void FlushChannel(uint_t channel, uint64_t t);
+
+  typedef struct {
+    AudioObjectParameters pending;        // merge of updates since last flush
+    AudioObjectParameters state;          // merge of all flushed updates
+    AudioObjectCursor     *cursor;
+    uint64_t              firsttime;      // time of first pending update
+    uint_t                updates;        // number of pending updates
+    bool                  listed;         // true if channel is in pendingchannels
+  } CHANNEL;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether channel is due to be flushed at time t according to the flush policy
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsDue(const CHANNEL& channel, uint64_t t) const;
+
+protected:
+  std::vector<CHANNEL>        channels;
+  std::vector<uint_t>         pendingchannels;    // list of channels with pending updates
+  uint64_t                    blockperiod;
+  uint64_t                    updatecount;
+  uint64_t                    outputcount;
+  FLUSHPOLICY                 policy;
+  uint_t                      maxupdates;
+  const AudioObjectParameters emptyparameters;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -0,0 +1,203 @@
+
+#define BBCDEBUG_LEVEL 1
+#include "TaskPool.h"
+
+BBC_AUDIOTOOLBOX_START
+
+TaskPool::TaskPool(uint_t nthreads) : queues(NULL),
+                                      task(NULL),
+                                      steals(0),
+                                      count(0),
+                                      completed(0),
+                                      active(0),
+                                      batch(0),
+                                      quit(false)
+{
+  uint_t i;
+
+  if (!nthreads)
+  {
+    uint_t hwthreads = std::thread::hardware_concurrency();
+    nthreads = (hwthreads > 1) ? hwthreads - 1 : 0;
+  }
+
+  queues = new QUEUE[nthreads + 1];
+  for (i = 0; i <= nthreads; i++) queues[i].begin = queues[i].end = 0;
+
+  // the calling thread uses queue 0
+  for (i = 0; i < nthreads; i++) threads.push_back(std::thread(&TaskPool::WorkerThread, this, i + 1));
+
+  BBCDEBUG3(("Started task pool with %u worker threads", nthreads));
+}
+
+TaskPool::~TaskPool()
+{
+  uint_t i;
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    quit = true;
+  }
+  started.notify_all();
+
+  for (i = 0; i < threads.size(); i++) threads[i].join();
+
+  delete[] queues;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Call task(n) for every n from 0 to count - 1 in parallel, returning when all have completed
+ */
+/*--------------------------------------------------------------------------------*/
+void TaskPool::Run(uint_t _count, const TASK& _task)
+{
+  std::lock_guard<std::mutex> runguard(runlock);
+  uint_t i;
+
+  if (threads.size() && (_count > 1))
+  {
+    uint_t nqueues = (uint_t)threads.size() + 1;
+    uint_t done, start = 0;
+
+    {
+      std::lock_guard<std::mutex> guard(lock);
+
+      // split range evenly between threads
+      for (i = 0; i < nqueues; i++)
+      {
+        std::lock_guard<std::mutex> queueguard(queues[i].lock);
+        uint_t n = (_count / nqueues) + ((i < (_count % nqueues)) ? 1 : 0);
+
+        queues[i].begin = start;
+        queues[i].end   = start += n;
+      }
+
+      task      = &_task;
+      count     = _count;
+      completed = 0;
+      batch++;
+    }
+    started.notify_all();
+
+    done = RunTasks(0, _task);
+
+    std::unique_lock<std::mutex> guard(lock);
+    completed += done;
+    // wait for all tasks to complete and all workers to leave the batch so none can take part in the next one
+    while ((completed < count) || active) finished.wait(guard);
+    task = NULL;
+  }
+  else
+  {
+    for (i = 0; i < _count; i++) _task(i);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Take next index for thread from its own queue or, if that is empty, by stealing from another
+ *
+ * @return false if there are no indices left in any queue
+ */
+/*--------------------------------------------------------------------------------*/
+bool TaskPool::Take(uint_t index, uint_t& n)
+{
+  uint_t nqueues = (uint_t)threads.size() + 1;
+  uint_t i;
+
+  {
+    QUEUE& queue = queues[index];
+    std::lock_guard<std::mutex> guard(queue.lock);
+
+    if (queue.begin < queue.end)
+    {
+      n = queue.begin++;
+      return true;
+    }
+  }
+
+  // own queue is empty, steal the back half of the next non-empty queue
+  for (i = 1; i < nqueues; i++)
+  {
+    QUEUE& victim = queues[(index + i) % nqueues];
+    uint_t begin, end;
+
+    {
+      std::lock_guard<std::mutex> guard(victim.lock);
+
+      if (victim.begin >= victim.end) continue;
+
+      end        = victim.end;
+      begin      = end - (end - victim.begin + 1) / 2;
+      victim.end = begin;
+    }
+
+    steals.fetch_add(1, std::memory_order_relaxed);
+
+    // run the first stolen index now and make the rest available (including to other thieves)
+    if ((begin + 1) < end)
+    {
+      QUEUE& queue = queues[index];
+      std::lock_guard<std::mutex> guard(queue.lock);
+
+      queue.begin = begin + 1;
+      queue.end   = end;
+    }
+
+    n = begin;
+    return true;
+  }
+
+  return false;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Run tasks of the current batch for thread until there are none left
+ *
+ * @return number of tasks run
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t TaskPool::RunTasks(uint_t index, const TASK& batchtask)
+{
+  uint_t n, done = 0;
+
+  while (Take(index, n))
+  {
+    batchtask(n);
+    done++;
+  }
+
+  return done;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Worker thread (index 0 is the thread calling Run())
+ */
+/*--------------------------------------------------------------------------------*/
+void TaskPool::WorkerThread(uint_t index)
+{
+  std::unique_lock<std::mutex> guard(lock);
+  uint64_t seen = 0;
+
+  while (!quit)
+  {
+    if ((batch != seen) && task)
+    {
+      const TASK *batchtask = task;
+      uint_t     done;
+
+      seen = batch;
+      active++;
+
+      guard.unlock();
+      done = RunTasks(index, *batchtask);
+      guard.lock();
+
+      completed += done;
+      active--;
+      finished.notify_all();
+    }
+    else started.wait(guard);
+  }
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,119 @@
+#ifndef __TASK_POOL__
+#define __TASK_POOL__
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <bbcat-base/misc.h>
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** A fixed set of worker threads for running batches of independent tasks in parallel
+ *
+ * Run() calls a function for each index in a range, spreading the calls over the worker
+ * threads and the calling thread, and returns once every call has completed.
+ *
+ * The range is initially split evenly between the threads, each of which works through its
+ * own part from the front.  A thread that runs out of work steals the back half of another
+ * thread's remaining part, so uneven task lengths are balanced automatically whilst threads
+ * rarely contend for the same indices.
+ *
+ * @note batches are run one at a time (concurrent Run() calls are serialised) and a task MUST
+ * NOT call Run() on the pool running it
+ */
+/*--------------------------------------------------------------------------------*/
+class TaskPool
+{
+public:
+  /*--------------------------------------------------------------------------------*/
+  /** Constructor
+   *
+   * @param nthreads number of worker threads (0 = one fewer than the number of hardware threads
+   * since the calling thread also runs tasks)
+   */
+  /*--------------------------------------------------------------------------------*/
+  TaskPool(uint_t nthreads = 0);
+  ~TaskPool();
+
+  typedef std::function<void(uint_t)> TASK;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Call task(n) for every n from 0 to count - 1 in parallel, returning when all have completed
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Run(uint_t _count, const TASK& _task);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of threads running tasks (including the calling thread)
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetConcurrency() const {return (uint_t)threads.size() + 1;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return total number of times a thread has stolen work from another
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint64_t GetStealCount() const {return steals.load(std::memory_order_relaxed);}
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Range of indices remaining for a thread
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef struct {
+    std::mutex lock;
+    uint_t     begin;
+    uint_t     end;
+  } QUEUE;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Take next index for thread from its own queue or, if that is empty, by stealing from another
+   *
+   * @return false if there are no indices left in any queue
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Take(uint_t index, uint_t& n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Run tasks of the current batch for thread until there are none left
+   *
+   * @return number of tasks run
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t RunTasks(uint_t index, const TASK& batchtask);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Worker thread (index 0 is the thread calling Run())
+   */
+  /*--------------------------------------------------------------------------------*/
+  void WorkerThread(uint_t index);
+
+protected:
+  std::vector<std::thread> threads;
+  QUEUE                    *queues;       // one per thread including the calling thread
+  std::mutex               runlock;       // serialises Run()
+  std::mutex               lock;          // protects batch details below
+  std::condition_variable  started;
+  std::condition_variable  finished;
+  const TASK               *task;
+  std::atomic<uint64_t>    steals;
+  uint_t                   count;
+  uint_t                   completed;     // number of tasks of the batch completed
+  uint_t                   active;        // number of workers taking part in the batch
+  uint64_t                 batch;         // incremented for each batch
+  bool                     quit;
+
+private:
+  // prevent copying
+  TaskPool(const TaskPool& obj);
+  TaskPool& operator = (const TaskPool& obj);
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif